@@ -1,13 +1,26 @@
-
 #include "performancecounters/benchmarker.h"
 #include "version_weaver.h"
+#include "version_weaver/catalog.h"
+#include "version_weaver/compressed_list.h"
+#include "version_weaver/async_resolver.h"
+#include "version_weaver/concurrent_catalog.h"
+#include "version_weaver/range.h"
+#include "version_weaver/resolver.h"
 #include <algorithm>
+#include <atomic>
 #include <charconv>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <latch>
+#include <map>
 #include <random>
+#include <shared_mutex>
 #include <stdlib.h>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 void pretty_print(size_t volume, size_t bytes, std::string name,
@@ -47,9 +60,1125 @@ void bench(const std::vector<std::string> &input) {
                      }
                    },
                    min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "compare",
+               bench(
+                   [&input, &sum]() {
+                     for (size_t i = 1; i < input.size(); i++) {
+                       sum = sum +
+                             (version_weaver::compare(input[i - 1], input[i]) <
+                              0);
+                     }
+                   },
+                   min_repeat, min_time_ns, max_repeat));  pretty_print(volume, bytes, "parse + operator<=>",
+               bench(
+                   [&input, &sum]() {
+                     for (size_t i = 1; i < input.size(); i++) {
+                       auto a = version_weaver::parse(input[i - 1]);
+                       auto b = version_weaver::parse(input[i]);
+                       sum = sum + (a && b && *a < *b);
+                     }
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "lazy_version <",
+               bench(
+                   [&input, &sum]() {
+                     for (size_t i = 1; i < input.size(); i++) {
+                       version_weaver::lazy_version a(input[i - 1]);
+                       version_weaver::lazy_version b(input[i]);
+                       sum = sum + (a < b);
+                     }
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+// Deterministic mix of release and pre-release versions, roughly shaped like
+// a registry dump: small majors, a long tail of minors and patches.
+std::vector<std::string> make_versions(size_t count) {
+  std::mt19937_64 rng(1234);
+  std::vector<std::string> versions;
+  versions.reserve(count);
+  const char *tags[] = {"alpha", "beta", "rc", "next", "canary", "dev"};
+  for (size_t i = 0; i < count; i++) {
+    std::string v = std::to_string(1 + rng() % 20) + "." +
+                     std::to_string(rng() % 40) + "." +
+                     std::to_string(rng() % 100);
+    if (rng() % 4 == 0) {
+      v += "-" + std::string(tags[rng() % 6]) + "." +
+           std::to_string(rng() % 10);
+    }
+    versions.push_back(std::move(v));
+  }
+  return versions;
+}
+
+void bench_sort(const std::vector<std::string> &input) {
+  std::vector<version_weaver::version> parsed;
+  size_t bytes = 0;
+  for (const auto &v : input) {
+    parsed.push_back(version_weaver::parse(v).value());
+    bytes += v.size();
+  }
+  size_t volume = parsed.size();
+  std::cout << "volume      : " << volume << " versions to sort" << std::endl;
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  pretty_print(volume, bytes, "std::sort",
+               bench(
+                   [&parsed]() {
+                     auto copy = parsed;
+                     std::sort(copy.begin(), copy.end(),
+                               [](const auto &a, const auto &b) {
+                                 return a < b;
+                               });
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "sort_versions",
+               bench(
+                   [&parsed]() {
+                     auto copy = parsed;
+                     version_weaver::sort_versions(copy);
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  pretty_print(volume, bytes,
+               "sort_versions (" + std::to_string(threads) + " threads)",
+               bench(
+                   [&parsed, threads]() {
+                     auto copy = parsed;
+                     version_weaver::sort_versions(copy, threads);
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "sort_versions + unique_versions",
+               bench(
+                   [&parsed]() {
+                     auto copy = parsed;
+                     version_weaver::sort_versions(copy);
+                     volatile size_t kept =
+                         version_weaver::unique_versions(copy);
+                     (void)kept;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+void bench_inc(const std::vector<std::string> &input) {
+  std::vector<version_weaver::version> parsed;
+  size_t bytes = 0;
+  for (const auto &v : input) {
+    parsed.push_back(version_weaver::parse(v).value());
+    bytes += v.size();
+  }
+  size_t volume = parsed.size();
+  std::cout << "volume      : " << volume << " versions to bump" << std::endl;
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  const std::pair<version_weaver::release_type, std::string> modes[] = {
+      {version_weaver::MAJOR, "major"},
+      {version_weaver::MINOR, "minor"},
+      {version_weaver::PATCH, "patch"},
+      {version_weaver::PRE_MAJOR, "premajor"},
+      {version_weaver::PRE_MINOR, "preminor"},
+      {version_weaver::PRE_PATCH, "prepatch"},
+      {version_weaver::PRE_RELEASE, "prerelease"},
+      {version_weaver::RELEASE, "release"},
+  };
+  for (const auto &[release_type, name] : modes) {
+    pretty_print(volume, bytes, "inc " + name + " (version_buffer)",
+                 bench(
+                     [&parsed, release_type]() {
+                       version_weaver::version_buffer output;
+                       size_t size = 0;
+                       for (const auto &v : parsed) {
+                         auto result = version_weaver::inc(v, release_type,
+                                                           output, "beta");
+                         size += result ? result->size() : 0;
+                       }
+                       volatile size_t sink = size;
+                       (void)sink;
+                     },
+                     min_repeat, min_time_ns, max_repeat));
+  }
+  pretty_print(volume, bytes, "inc prerelease (std::string)",
+               bench(
+                   [&parsed]() {
+                     size_t size = 0;
+                     for (const auto &v : parsed) {
+                       auto result = version_weaver::inc(
+                           v, version_weaver::PRE_RELEASE, "beta");
+                       size += result ? result->size() : 0;
+                     }
+                     volatile size_t sink = size;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+void bench_hash(const std::vector<std::string> &input) {
+  std::vector<version_weaver::version> parsed;
+  size_t bytes = 0;
+  for (const auto &v : input) {
+    parsed.push_back(version_weaver::parse(v).value());
+    bytes += v.size();
+  }
+  size_t volume = parsed.size();
+  std::cout << "volume      : " << volume << " versions to deduplicate"
+            << std::endl;
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  pretty_print(volume, bytes, "precedence_hash",
+               bench(
+                   [&parsed]() {
+                     uint64_t h = 0;
+                     for (const auto &v : parsed) {
+                       h ^= version_weaver::precedence_hash(v);
+                     }
+                     volatile uint64_t sink = h;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "unordered_set<version>",
+               bench(
+                   [&parsed]() {
+                     std::unordered_set<version_weaver::version> set(
+                         parsed.begin(), parsed.end());
+                     volatile size_t sink = set.size();
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "unordered_set<std::string>",
+               bench(
+                   [&parsed]() {
+                     std::unordered_set<std::string> set;
+                     for (const auto &v : parsed) {
+                       set.insert(std::string(v));
+                     }
+                     volatile size_t sink = set.size();
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+// Cold start: parsing every version string of a package set, against opening
+// a catalog of the same versions and reading them back.
+void bench_catalog(const std::vector<std::string> &input) {
+  size_t bytes = 0;
+  for (const auto &v : input) {
+    bytes += v.size();
+  }
+  size_t volume = input.size();
+  version_weaver::catalog_writer writer;
+  const size_t per_package = 100;
+  for (size_t i = 0; i < volume; i += per_package) {
+    std::vector<std::string_view> versions(
+        input.begin() + i, input.begin() + std::min(volume, i + per_package));
+    (void)writer.add("package-" + std::to_string(i / per_package), versions);
+  }
+  const std::vector<std::byte> catalog = writer.finish();
+  std::cout << "volume      : " << volume << " versions, "
+            << catalog.size() / 1024 / 1024. << " MB catalog" << std::endl;
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  pretty_print(volume, bytes, "parse every version",
+               bench(
+                   [&input]() {
+                     std::vector<version_weaver::version> parsed;
+                     parsed.reserve(input.size());
+                     for (std::string_view v : input) {
+                       parsed.push_back(version_weaver::parse(v).value());
+                     }
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "catalog_view::open + read",
+               bench(
+                   [&catalog]() {
+                     auto view = version_weaver::catalog_view::open(catalog);
+                     size_t sum = 0;
+                     for (size_t p = 0; p < view->package_count(); p++) {
+                       auto versions = view->package(p);
+                       for (size_t i = 0; i < versions.size(); i++) {
+                         sum += versions[i].major.size();
+                       }
+                     }
+                     volatile size_t sink = sum;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, bytes, "catalog_view::validate",
+               bench(
+                   [&catalog]() {
+                     auto view = version_weaver::catalog_view::open(catalog);
+                     volatile bool valid = view->validate().has_value();
+                     (void)valid;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+void bench_compressed_list(const std::vector<std::string> &input) {
+  std::vector<version_weaver::version> sorted;
+  for (const auto &v : input) {
+    sorted.push_back(version_weaver::parse(v).value());
+  }
+  version_weaver::sort_versions(sorted);
+  auto list = version_weaver::compressed_version_list::encode(sorted).value();
+  std::cout << "volume      : " << sorted.size() << " versions, "
+            << list.byte_size() / double(sorted.size())
+            << " bytes per version compressed, "
+            << sizeof(version_weaver::version) << " bytes as version"
+            << std::endl;
+  std::vector<version_weaver::version> probes;
+  for (size_t i = 0; i < sorted.size(); i += 97) {
+    probes.push_back(sorted[i]);
+  }
+  size_t volume = probes.size();
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 100000;
+  pretty_print(volume, volume, "std::upper_bound on versions",
+               bench(
+                   [&sorted, &probes]() {
+                     size_t sum = 0;
+                     for (const auto &p : probes) {
+                       sum += std::upper_bound(sorted.begin(), sorted.end(), p,
+                                               [](const auto &a,
+                                                  const auto &b) {
+                                                 return a < b;
+                                               }) -
+                              sorted.begin();
+                     }
+                     volatile size_t sink = sum;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(volume, volume, "compressed_version_list::upper_bound",
+               bench(
+                   [&list, &probes]() {
+                     size_t sum = 0;
+                     for (const auto &p : probes) {
+                       sum += list.upper_bound(p);
+                     }
+                     volatile size_t sink = sum;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+std::vector<std::string> make_ranges(size_t count) {
+  std::mt19937_64 rng(4321);
+  std::vector<std::string> ranges;
+  ranges.reserve(count);
+  const char *ops[] = {"^", "~", ">=", ">", "<", "<="};
+  for (size_t i = 0; i < count; i++) {
+    std::string bound = std::to_string(1 + rng() % 20) + "." +
+                        std::to_string(rng() % 40) + "." +
+                        std::to_string(rng() % 100);
+    std::string r = std::string(ops[rng() % 6]) + bound;
+    if (rng() % 4 == 0) {
+      r += " || >=" + std::to_string(21 + rng() % 10) + ".0.0";
+    }
+    ranges.push_back(std::move(r));
+  }
+  return ranges;
+}
+
+// Runs `work` on `threads` threads at once, each over the whole shared input,
+// and returns the wall-clock time in nanoseconds. The clock starts only once
+// every thread is ready, so thread creation is not part of the measurement.
+template <class function_type>
+double run_on_threads(size_t threads, const function_type &work) {
+  std::latch ready(threads);
+  std::latch go(1);
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&ready, &go, &work]() {
+      ready.count_down();
+      go.wait();
+      work();
+    });
+  }
+  ready.wait();
+  auto start = std::chrono::steady_clock::now();
+  go.count_down();
+  for (auto &w : workers) {
+    w.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Reports throughput scaling of `work` (which processes `volume` items per
+// call) from 1 to `max_threads` threads. Efficiency is the throughput per
+// thread relative to the single-threaded run: 100% means perfect scaling,
+// anything lower points at shared state, false sharing or allocator
+// contention.
+template <class function_type>
+void scale(std::string name, size_t volume, size_t max_threads,
+           const function_type &work) {
+  std::vector<size_t> counts;
+  for (size_t t = 1; t < max_threads; t *= 2) {
+    counts.push_back(t);
+  }
+  counts.push_back(max_threads);
+  double single = 0;
+  for (size_t threads : counts) {
+    // Best of a few runs to filter out scheduling noise.
+    double best = run_on_threads(threads, work);
+    for (size_t r = 0; r < 2; r++) {
+      best = std::min(best, run_on_threads(threads, work));
+    }
+    double throughput = double(volume) * threads / best * 1e3;  // M/s
+    if (threads == 1) {
+      single = throughput;
+    }
+    printf("%-24s : %3zu threads  %10.4f M/s  speedup %5.2f  efficiency %5.1f %%\n",
+           name.c_str(), threads, throughput, throughput / single,
+           throughput / (single * threads) * 100.0);
+  }
+}
+
+void bench_threads(size_t max_threads) {
+  const auto input = make_versions(20000);
+  const auto ranges = make_ranges(2000);
+  std::vector<version_weaver::version> parsed;
+  parsed.reserve(input.size());
+  for (const auto &v : input) {
+    parsed.push_back(version_weaver::parse(v).value());
+  }
+  std::cout << "threads     : 1.." << max_threads << std::endl;
+  std::cout << "volume      : " << input.size() << " versions, "
+            << ranges.size() << " ranges per thread" << std::endl;
+
+  scale("parse", input.size(), max_threads, [&input]() {
+    size_t sum = 0;
+    for (std::string_view v : input) {
+      sum += version_weaver::parse(v).has_value();
+    }
+    volatile size_t sink = sum;
+    (void)sink;
+  });
+  scale("compare", parsed.size(), max_threads, [&parsed]() {
+    size_t sum = 0;
+    for (size_t i = 1; i < parsed.size(); i++) {
+      sum += (parsed[i - 1] < parsed[i]);
+    }
+    volatile size_t sink = sum;
+    (void)sink;
+  });
+  scale("compare (strings)", input.size(), max_threads, [&input]() {
+    size_t sum = 0;
+    for (size_t i = 1; i < input.size(); i++) {
+      sum += (version_weaver::compare(input[i - 1], input[i]) < 0);
+    }
+    volatile size_t sink = sum;
+    (void)sink;
+  });
+  scale("coerce", input.size(), max_threads, [&input]() {
+    size_t sum = 0;
+    for (std::string_view v : input) {
+      sum += version_weaver::coerce(v).has_value();
+    }
+    volatile size_t sink = sum;
+    (void)sink;
+  });
+  scale("minimum", ranges.size(), max_threads, [&ranges]() {
+    size_t sum = 0;
+    for (std::string_view r : ranges) {
+      sum += version_weaver::minimum(r).has_value();
+    }
+    volatile size_t sink = sum;
+    (void)sink;
+  });
+
+  // Every thread evaluates the same range.
+  const std::string_view range_text = "^1.2 || >=3.0.0 <12.0.0";
+  const auto range = version_weaver::parse_range(range_text).value();
+  const version_weaver::compiled_range compiled(range);
+  scale("satisfies", input.size(), max_threads, [&input, range_text]() {
+    size_t sum = 0;
+    for (std::string_view v : input) {
+      sum += version_weaver::satisfies(v, range_text);
+    }
+    volatile size_t sink = sum;
+    (void)sink;
+  });
+  scale("range::test", parsed.size(), max_threads, [&parsed, &range]() {
+    size_t sum = 0;
+    for (const auto &v : parsed) {
+      sum += range.test(v);
+    }
+    volatile size_t sink = sum;
+    (void)sink;
+  });
+  scale("compiled_range::test", parsed.size(), max_threads,
+        [&parsed, &compiled]() {
+          size_t sum = 0;
+          for (const auto &v : parsed) {
+            sum += compiled.test(v);
+          }
+          volatile size_t sink = sum;
+          (void)sink;
+        });
+}
+
+// Baseline for concurrent_catalog: a map behind a reader-writer lock. New
+// lists are also built before taking the lock.
+class locked_catalog {
+ public:
+  void publish(const std::string &package,
+               std::span<const version_weaver::version> versions) {
+    std::vector<std::string> text;
+    for (const auto &v : versions) {
+      text.push_back(std::string(v));
+    }
+    std::vector<version_weaver::version> list;
+    for (const auto &v : text) {
+      list.push_back(version_weaver::parse(v).value());
+    }
+    version_weaver::sort_versions(list);
+    std::unique_lock lock(mutex_);
+    auto &entry = packages_[package];
+    entry.first = std::move(text);
+    entry.second = std::move(list);
+  }
+
+  // Number of versions of `package` that are at most `probe`.
+  size_t count_up_to(const std::string &package,
+                     const version_weaver::version &probe) const {
+    std::shared_lock lock(mutex_);
+    auto entry = packages_.find(package);
+    if (entry == packages_.end()) {
+      return 0;
+    }
+    const auto &list = entry->second.second;
+    return std::upper_bound(list.begin(), list.end(), probe) - list.begin();
+  }
+
+ private:
+  mutable std::shared_mutex mutex_;
+  std::map<std::string, std::pair<std::vector<std::string>,
+                                  std::vector<version_weaver::version>>>
+      packages_;
+};
+
+// Readers look up packages while a writer keeps publishing new lists.
+void bench_concurrent_catalog(size_t max_threads) {
+  const size_t package_count = 1000;
+  const size_t lookups = 20000;
+  std::vector<std::string> packages;
+  for (size_t i = 0; i < package_count; i++) {
+    packages.push_back("package-" + std::to_string(i));
+  }
+  const auto text = make_versions(200);
+  std::vector<version_weaver::version> versions;
+  for (const auto &v : text) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  const auto probe = version_weaver::parse("10.0.0").value();
+  std::cout << "volume      : " << package_count << " packages of "
+            << versions.size() << " versions, " << lookups
+            << " lookups per thread, one writer" << std::endl;
+
+  auto with_writer = [&](auto &catalog, auto &&measure) {
+    for (const auto &package : packages) {
+      catalog.publish(package, versions);
+    }
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+      for (size_t i = 0; !done.load(std::memory_order_relaxed); i++) {
+        catalog.publish(packages[i % packages.size()], versions);
+      }
+    });
+    measure();
+    done = true;
+    writer.join();
+  };
+
+  version_weaver::concurrent_catalog catalog;
+  with_writer(catalog, [&]() {
+    scale("concurrent_catalog", lookups, max_threads, [&]() {
+      version_weaver::concurrent_catalog::reader reader(catalog);
+      size_t sum = 0;
+      for (size_t i = 0; i < lookups; i++) {
+        auto snapshot = reader.pin();
+        auto list = snapshot.find(packages[i % packages.size()]);
+        sum += std::upper_bound(list.begin(), list.end(), probe) - list.begin();
+      }
+      volatile size_t sink = sum;
+      (void)sink;
+    });
+  });
+  locked_catalog baseline;
+  with_writer(baseline, [&]() {
+    scale("shared_mutex catalog", lookups, max_threads, [&]() {
+      size_t sum = 0;
+      for (size_t i = 0; i < lookups; i++) {
+        sum += baseline.count_up_to(packages[i % packages.size()], probe);
+      }
+      volatile size_t sink = sum;
+      (void)sink;
+    });
+  });
+}
+
+// Resolving a manifest against a synthetic registry of layered packages, each
+// depending on three packages of the next layer. The highest version of every
+// tenth package depends on a missing package, which forces a backtrack.
+void bench_resolver() {
+  const size_t layers = 8;
+  const size_t width = 1500;
+  const size_t releases = 5;
+  std::string text;
+  for (size_t layer = 0; layer < layers; layer++) {
+    for (size_t i = 0; i < width; i++) {
+      std::string name = "p" + std::to_string(layer) + "-" + std::to_string(i);
+      for (size_t minor = 0; minor < releases; minor++) {
+        text += name + "\t1." + std::to_string(minor) + ".0";
+        for (size_t d = 0; layer + 1 < layers && d < 3; d++) {
+          size_t child = (i * 31 + d * 577 + minor) % width;
+          text += "\tp" + std::to_string(layer + 1) + "-" +
+                  std::to_string(child) + (d == 0 ? "\t^1.1.0" : "\t~1.2.0");
+        }
+        if (minor + 1 == releases && i % 10 == 0) {
+          text += "\tmissing\t*";
+        }
+        text += "\n";
+      }
+    }
+  }
+  auto packages = version_weaver::registry::parse(text).value();
+  std::vector<std::string> names;
+  for (size_t i = 0; i < width; i += 15) {
+    names.push_back("p0-" + std::to_string(i));
+  }
+  std::vector<version_weaver::dependency> manifest;
+  for (const auto &name : names) {
+    manifest.push_back({name, "^1.0.0"});
+  }
+  size_t volume = version_weaver::resolve(packages, manifest)->packages.size();
+  std::cout << "volume      : " << packages.size() << " packages, "
+            << manifest.size() << " roots, " << volume << " resolved"
+            << std::endl;
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  std::vector<size_t> counts = {1};
+  if (std::thread::hardware_concurrency() > 1) {
+    counts.push_back(std::thread::hardware_concurrency());
+  }
+  for (size_t t : counts) {
+    pretty_print(volume, text.size(),
+                 "resolve (" + std::to_string(t) + " threads)",
+                 bench(
+                     [&packages, &manifest, t]() {
+                       auto result = version_weaver::resolve(
+                           packages, manifest, {.threads = t});
+                       volatile size_t sink = result->packages.size();
+                       (void)sink;
+                     },
+                     min_repeat, min_time_ns, max_repeat));
+  }
+
+  // A chain of packages whose last link depends on the missing package, so
+  // that no version of any link resolves.
+  const size_t links = 40;
+  std::string chain;
+  for (size_t link = 0; link < links; link++) {
+    std::string next =
+        link + 1 < links ? "c" + std::to_string(link + 1) : "missing";
+    for (size_t minor = 0; minor < releases; minor++) {
+      chain += "c" + std::to_string(link) + "\t1." + std::to_string(minor) +
+               ".0\t" + next + "\t^1.0.0\n";
+    }
+  }
+  auto chained = version_weaver::registry::parse(chain).value();
+  std::vector<version_weaver::dependency> first = {{"c0", "^1.0.0"}};
+  pretty_print(links * releases, chain.size(), "resolve (unresolvable chain)",
+               bench(
+                   [&chained, &first]() {
+                     auto result = version_weaver::resolve(chained, first);
+                     volatile bool sink = result.has_value();
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+// Sorting a catalog where 40% of the versions are pre-releases, comparing
+// pre-release strings against comparing interned pre-releases.
+void bench_pre_release_table() {
+  std::mt19937_64 rng(7);
+  const std::vector<std::string> tags = {"alpha", "beta", "rc", "next",
+                                         "canary", "dev"};
+  std::vector<std::string> text;
+  for (size_t i = 0; i < 100000; i++) {
+    std::string v = std::to_string(1 + rng() % 5) + "." +
+                    std::to_string(rng() % 10) + "." + std::to_string(rng() % 4);
+    if (rng() % 10 < 4) {
+      v += "-" + tags[rng() % tags.size()] + "." + std::to_string(rng() % 30);
+      if (rng() % 4 == 0) {
+        v += ".g" + std::to_string(rng() % 200);
+      }
+    }
+    text.push_back(v);
+  }
+  std::vector<version_weaver::version> versions;
+  size_t bytes = 0;
+  for (const auto &v : text) {
+    versions.push_back(version_weaver::parse(v).value());
+    bytes += v.size();
+  }
+  version_weaver::pre_release_table table;
+  std::vector<version_weaver::pre_release_table::id> ids;
+  for (const auto &v : versions) {
+    ids.push_back(table.intern(v.pre_release));
+  }
+  std::cout << "volume      : " << versions.size() << " versions, "
+            << table.symbol_count() << " interned identifiers" << std::endl;
+  struct interned_version {
+    version_weaver::version v;
+    version_weaver::pre_release_table::id pre_release;
+  };
+  std::vector<interned_version> interned;
+  std::vector<std::optional<std::string_view>> pre_releases;
+  std::vector<version_weaver::pre_release_table::id> pre_release_ids;
+  for (size_t i = 0; i < versions.size(); i++) {
+    interned.push_back({versions[i], ids[i]});
+    if (versions[i].pre_release.has_value()) {
+      pre_releases.push_back(versions[i].pre_release);
+      pre_release_ids.push_back(ids[i]);
+    }
+  }
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  pretty_print(versions.size(), bytes, "std::sort, operator<",
+               bench(
+                   [&versions]() {
+                     auto copy = versions;
+                     std::sort(copy.begin(), copy.end(),
+                               [](const auto &a, const auto &b) {
+                                 return a < b;
+                               });
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(versions.size(), bytes, "std::sort, pre_release_table",
+               bench(
+                   [&interned, &table]() {
+                     auto copy = interned;
+                     std::sort(copy.begin(), copy.end(),
+                               [&table](const auto &a, const auto &b) {
+                                 return table.compare(a.v, a.pre_release, b.v,
+                                                      b.pre_release) < 0;
+                               });
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(pre_releases.size(), bytes, "sort pre-releases (strings)",
+               bench(
+                   [&pre_releases]() {
+                     auto copy = pre_releases;
+                     std::sort(copy.begin(), copy.end(),
+                               [](const auto &a, const auto &b) {
+                                 return version_weaver::compare_pre_release(
+                                            a, b) < 0;
+                               });
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(pre_release_ids.size(), bytes, "sort pre-releases (interned)",
+               bench(
+                   [&pre_release_ids, &table]() {
+                     auto copy = pre_release_ids;
+                     std::sort(copy.begin(), copy.end(),
+                               [&table](const auto &a, const auto &b) {
+                                 return table.compare(a, b) < 0;
+                               });
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+// "Latest 1.x, latest 2.x, ..." and the latest patch of every minor line of
+// a package with thousands of releases, against filtering and sorting the
+// version strings once per line.
+void bench_release_lines() {
+  std::vector<std::string> text;
+  for (size_t major = 1; major <= 12; major++) {
+    for (size_t minor = 0; minor < 25; minor++) {
+      for (size_t patch = 0; patch < 20; patch++) {
+        std::string v = std::to_string(major) + "." + std::to_string(minor) +
+                        "." + std::to_string(patch);
+        text.push_back(patch % 7 == 3 ? v + "-rc.1" : v);
+      }
+    }
+  }
+  std::vector<version_weaver::version> sorted;
+  size_t bytes = 0;
+  for (const auto &v : text) {
+    sorted.push_back(version_weaver::parse(v).value());
+    bytes += v.size();
+  }
+  version_weaver::sort_versions(sorted);
+  std::cout << "volume      : " << sorted.size() << " versions" << std::endl;
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 100000;
+  pretty_print(text.size(), bytes, "latest per major (filter + sort strings)",
+               bench(
+                   [&text]() {
+                     size_t sum = 0;
+                     for (size_t major = 1; major <= 12; major++) {
+                       std::string prefix = std::to_string(major) + ".";
+                       std::vector<std::string> line;
+                       for (const auto &v : text) {
+                         if (v.starts_with(prefix) &&
+                             v.find('-') == std::string::npos) {
+                           line.push_back(v);
+                         }
+                       }
+                       std::sort(line.begin(), line.end(),
+                                 [](const auto &a, const auto &b) {
+                                   return version_weaver::compare(a, b) < 0;
+                                 });
+                       sum += line.back().size();
+                     }
+                     volatile size_t sink = sum;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  for (auto [kind, name] :
+       {std::pair{version_weaver::MAJOR_LINE, "release_lines (major)"},
+        std::pair{version_weaver::MINOR_LINE, "release_lines (minor)"}}) {
+    pretty_print(sorted.size(), bytes, name,
+                 bench(
+                     [&sorted, kind]() {
+                       auto lines = version_weaver::release_lines(sorted, kind);
+                       volatile size_t sink = lines.back().latest;
+                       (void)sink;
+                     },
+                     min_repeat, min_time_ns, max_repeat));
+  }
+}
+
+// Versions in 10k user-agent lines, one line at a time with coerce() and the
+// whole buffer at once with coerce_all().
+void bench_coerce_all() {
+  std::mt19937_64 rng(42);
+  std::string buffer;
+  std::vector<std::string_view> lines;
+  std::vector<size_t> line_ends;
+  for (size_t i = 0; i < 10000; i++) {
+    buffer += "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 Chrome/" +
+              std::to_string(100 + rng() % 30) + ".0." +
+              std::to_string(rng() % 7000) + "." + std::to_string(rng() % 200) +
+              " node/v" + std::to_string(14 + rng() % 10) + "." +
+              std::to_string(rng() % 20) + ".1\n";
+    line_ends.push_back(buffer.size());
+  }
+  for (size_t i = 0, begin = 0; i < line_ends.size(); i++) {
+    lines.push_back(
+        std::string_view(buffer).substr(begin, line_ends[i] - begin));
+    begin = line_ends[i];
+  }
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  pretty_print(lines.size(), buffer.size(), "coerce (first per line)",
+               bench(
+                   [&lines]() {
+                     size_t sum = 0;
+                     for (std::string_view line : lines) {
+                       sum += version_weaver::coerce(line).has_value();
+                     }
+                     volatile size_t sink = sum;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  std::vector<version_weaver::coerced_version> found;
+  pretty_print(lines.size(), buffer.size(), "coerce_all (every version)",
+               bench(
+                   [&buffer, &found]() {
+                     version_weaver::coerce_all(buffer, found);
+                     volatile size_t sink = found.size();
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+// A lockfile of 20k (range, version) pairs over a few hundred distinct
+// ranges, checked pair by pair with satisfies() and as a batch.
+void bench_verify_lockfile() {
+  std::mt19937_64 rng(42);
+  const size_t count = 20000;
+  std::vector<std::string> ranges;
+  std::vector<std::string> versions;
+  for (size_t i = 0; i < count; i++) {
+    // Popular ranges come up far more often than the others.
+    size_t major = 1 + std::min<size_t>(rng() % 40, rng() % 40);
+    size_t minor = rng() % 20;
+    ranges.push_back((i % 2 ? "^" : "~") + std::to_string(major) + "." +
+                     std::to_string(minor / 4) + ".0");
+    versions.push_back(std::to_string(major) + "." + std::to_string(minor) +
+                       "." + std::to_string(rng() % 10));
+  }
+  std::vector<version_weaver::locked_pair> pairs;
+  size_t bytes = 0;
+  for (size_t i = 0; i < count; i++) {
+    pairs.push_back({ranges[i], versions[i]});
+    bytes += ranges[i].size() + versions[i].size();
+  }
+  std::unordered_set<std::string_view> distinct(ranges.begin(), ranges.end());
+  std::cout << "volume      : " << count << " pairs, " << distinct.size()
+            << " distinct ranges" << std::endl;
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  pretty_print(count, bytes, "satisfies, pair by pair",
+               bench(
+                   [&pairs]() {
+                     size_t failing = 0;
+                     for (const auto &pair : pairs) {
+                       failing += !version_weaver::satisfies(pair.version,
+                                                             pair.range);
+                     }
+                     volatile size_t sink = failing;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  std::vector<size_t> counts = {1};
+  if (std::thread::hardware_concurrency() > 1) {
+    counts.push_back(std::thread::hardware_concurrency());
+  }
+  for (size_t t : counts) {
+    pretty_print(count, bytes,
+                 "verify_lockfile (" + std::to_string(t) + " threads)",
+                 bench(
+                     [&pairs, t]() {
+                       volatile size_t sink =
+                           version_weaver::verify_lockfile(pairs, t).size();
+                       (void)sink;
+                     },
+                     min_repeat, min_time_ns, max_repeat));
+  }
+}
+
+void bench_range_test() {
+  std::mt19937_64 rng(42);
+  std::vector<std::string> texts;
+  std::vector<std::string> nightly_texts;
+  for (size_t i = 0; i < 100000; i++) {
+    texts.push_back(std::to_string(10 + rng() % 20) + "." +
+                    std::to_string(rng() % 20) + "." +
+                    std::to_string(rng() % 10));
+    nightly_texts.push_back(texts.back() + "-nightly." +
+                            std::to_string(20240101 + rng() % 365));
+  }
+  auto parse_all = [](const std::vector<std::string> &all, size_t &bytes) {
+    std::vector<version_weaver::version> versions;
+    bytes = 0;
+    for (const auto &text : all) {
+      versions.push_back(version_weaver::parse(text).value());
+      bytes += text.size();
+    }
+    return versions;
+  };
+  size_t bytes;
+  size_t nightly_bytes;
+  auto versions = parse_all(texts, bytes);
+  auto nightlies = parse_all(nightly_texts, nightly_bytes);
+  size_t min_repeat = 10;
+  size_t min_time_ns = 1000000000;
+  size_t max_repeat = 1000;
+  auto run = [&](const std::vector<version_weaver::version> &input,
+                 size_t input_bytes, std::string name, const auto &test) {
+    pretty_print(input.size(), input_bytes, name,
+                 bench(
+                     [&input, &test]() {
+                       size_t matching = 0;
+                       for (const auto &v : input) {
+                         matching += test(v);
+                       }
+                       volatile size_t sink = matching;
+                       (void)sink;
+                     },
+                     min_repeat, min_time_ns, max_repeat));
+  };
+  auto parsed = version_weaver::parse_range(">=18.0.0 <23.0.0").value();
+  version_weaver::compiled_range compiled(parsed);
+  run(versions, bytes, "range::test",
+      [&parsed](const auto &v) { return parsed.test(v); });
+  run(versions, bytes, "compiled_range::test",
+      [&compiled](const auto &v) { return compiled.test(v); });
+  run(versions, bytes, "static_range::test", [](const auto &v) {
+    return version_weaver::static_range<">=18.0.0 <23.0.0">::test(v);
+  });
+
+  auto alternatives =
+      version_weaver::parse_range("^10.1.0 || ~12.4.0 || 14.x || >=27.0.0")
+          .value();
+  version_weaver::compiled_range compiled_alternatives(alternatives);
+  run(versions, bytes, "range::test (4 sets)",
+      [&alternatives](const auto &v) { return alternatives.test(v); });
+  run(versions, bytes, "compiled_range::test (4 sets)",
+      [&compiled_alternatives](const auto &v) {
+        return compiled_alternatives.test(v);
+      });
+
+  // Nightlies only satisfy ranges with include_prerelease.
+  auto including = version_weaver::parse_range(
+                       ">=18.0.0 <23.0.0", {.include_prerelease = true})
+                       .value();
+  version_weaver::compiled_range compiled_including(including);
+  run(nightlies, nightly_bytes, "range::test (nightlies)",
+      [&including](const auto &v) { return including.test(v); });
+  run(nightlies, nightly_bytes, "compiled_range::test (nightlies)",
+      [&compiled_including](const auto &v) {
+        return compiled_including.test(v);
+      });
+
+  // The highest satisfying version, by testing every version, and by
+  // max_satisfying(), which tests only those above the best so far.
+  pretty_print(versions.size(), bytes, "test and compare",
+               bench(
+                   [&versions, &compiled]() {
+                     const version_weaver::version *best = nullptr;
+                     for (const auto &v : versions) {
+                       if (compiled.test(v) && (!best || *best < v)) {
+                         best = &v;
+                       }
+                     }
+                     volatile bool sink = best != nullptr;
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+  pretty_print(versions.size(), bytes, "max_satisfying",
+               bench(
+                   [&versions, &compiled]() {
+                     auto best =
+                         version_weaver::max_satisfying(versions, compiled);
+                     volatile bool sink = best.has_value();
+                     (void)sink;
+                   },
+                   min_repeat, min_time_ns, max_repeat));
+}
+
+// The sequential baseline of resolve_async(): the same packages are fetched,
+// one at a time.
+version_weaver::task<std::expected<version_weaver::resolution,
+                                   version_weaver::resolve_error>>
+resolve_sequentially(version_weaver::metadata_source &source,
+                     version_weaver::executor &pool,
+                     std::span<const version_weaver::dependency> manifest) {
+  std::unordered_map<std::string_view, const version_weaver::registry_package *>
+      fetched;
+  std::unordered_set<std::string> expanded;
+  std::vector<version_weaver::dependency> queue(manifest.begin(),
+                                                manifest.end());
+  for (size_t head = 0; head < queue.size(); head++) {
+    auto [name, range_text] = queue[head];
+    if (!expanded.insert(std::string(name) + '\0' + std::string(range_text))
+             .second) {
+      continue;
+    }
+    if (!fetched.contains(name)) {
+      fetched[name] = co_await version_weaver::fetch(source, name, pool);
+    }
+    if (fetched[name] == nullptr) {
+      continue;
+    }
+    auto parsed = version_weaver::parse_range(range_text).value();
+    for (const auto &v : fetched[name]->versions) {
+      if (parsed.test(v.release)) {
+        queue.insert(queue.end(), v.dependencies.begin(), v.dependencies.end());
+      }
+    }
+  }
+  co_return version_weaver::resolve(
+      [&fetched](std::string_view name) {
+        auto entry = fetched.find(name);
+        return entry == fetched.end() ? nullptr : entry->second;
+      },
+      manifest);
+}
+
+// Resolution bound by metadata latency: every fetch from the registry takes
+// one millisecond. resolve_async() keeps every known fetch in flight.
+void bench_async_resolver() {
+  const size_t layers = 4;
+  const size_t width = 60;
+  std::string text;
+  for (size_t layer = 0; layer < layers; layer++) {
+    for (size_t i = 0; i < width; i++) {
+      for (size_t minor = 0; minor < 3; minor++) {
+        text += "p" + std::to_string(layer) + "-" + std::to_string(i) + "\t1." +
+                std::to_string(minor) + ".0";
+        for (size_t d = 0; layer + 1 < layers && d < 2; d++) {
+          text += "\tp" + std::to_string(layer + 1) + "-" +
+                  std::to_string((i * 7 + d * 11 + minor) % width) + "\t^1.1.0";
+        }
+        text += "\n";
+      }
+    }
+  }
+  auto packages = version_weaver::registry::parse(text).value();
+  std::vector<std::string> names;
+  for (size_t i = 0; i < width; i += 3) {
+    names.push_back("p0-" + std::to_string(i));
+  }
+  std::vector<version_weaver::dependency> manifest;
+  for (const auto &name : names) {
+    manifest.push_back({name, "^1.0.0"});
+  }
+  version_weaver::executor pool(2);
+  auto measure = [&](const char *name, auto &&resolver) {
+    double best = 1e300;
+    size_t fetches = 0;
+    size_t in_flight = 0;
+    for (size_t repeat = 0; repeat < 3; repeat++) {
+      version_weaver::registry_source source(packages,
+                                             std::chrono::milliseconds(1));
+      auto start = std::chrono::steady_clock::now();
+      auto result = version_weaver::sync_wait(resolver(source));
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
+      fetches = source.fetch_count();
+      in_flight = source.max_in_flight();
+      (void)result.value();
+    }
+    printf("%-40s : %8.2f ms  %4zu fetches  %4zu in flight at most\n", name,
+           best, fetches, in_flight);
+  };
+  measure("resolve_async", [&](auto &source) {
+    return version_weaver::resolve_async(source, pool, manifest);
+  });
+  measure("resolve, one fetch at a time", [&](auto &source) {
+    return resolve_sequentially(source, pool, manifest);
+  });
 }
 
 int main(int argc, char **argv) {
+  // benchmark --threads [N]: report multi-threaded scaling on 1..N threads.
+  if (argc > 1 && std::strcmp(argv[1], "--threads") == 0) {
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 2) {
+      std::from_chars(argv[2], argv[2] + std::strlen(argv[2]), max_threads);
+    }
+    bench_threads(std::max<size_t>(max_threads, 1));
+    bench_concurrent_catalog(std::max<size_t>(max_threads, 1));
+    return EXIT_SUCCESS;
+  }
   bench({"1.2.4", "13.4.1"});
+  bench_sort(make_versions(1000000));
+  bench_inc(make_versions(100000));
+  bench_hash(make_versions(100000));
+  bench_catalog(make_versions(1000000));
+  bench_compressed_list(make_versions(100000));
+  bench_pre_release_table();
+  bench_release_lines();
+  bench_coerce_all();
+  bench_verify_lockfile();
+  bench_range_test();
+  bench_resolver();
+  bench_async_resolver();
   return EXIT_SUCCESS;
 }
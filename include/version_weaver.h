@@ -1,8 +1,17 @@
 #ifndef VERSION_WEAVER_H
 #define VERSION_WEAVER_H
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <expected>
 
 namespace version_weaver {
@@ -27,8 +36,14 @@ bool validate(std::string_view version);
 bool satisfies(std::string_view version, std::string_view range);
 std::optional<std::string> coerce(const std::string_view version);
 std::optional<std::string> incrementVersion(std::string_view version);
+std::optional<std::pmr::string> incrementVersion(
+    std::string_view version, std::pmr::memory_resource* resource);
 std::optional<std::string> decrementVersion(std::string_view version);
+std::optional<std::pmr::string> decrementVersion(
+    std::string_view version, std::pmr::memory_resource* resource);
 std::optional<std::string> minimum(std::string_view range);
+std::optional<std::pmr::string> minimum(std::string_view range,
+                                        std::pmr::memory_resource* resource);
 
 // A normal version number MUST take the form X.Y.Z where X, Y, and Z are
 // non-negative integers, and MUST NOT contain leading zeroes.
@@ -75,6 +90,22 @@ struct version {
     }
     return result;
   }
+
+  // The same text, allocated once from `resource`.
+  std::pmr::string to_string(std::pmr::memory_resource* resource) const {
+    std::pmr::string result(resource);
+    result.reserve(major.size() + minor.size() + patch.size() + 2 +
+                   (pre_release.has_value() ? pre_release->size() + 1 : 0) +
+                   (build.has_value() ? build->size() + 1 : 0));
+    result.append(major).append(".").append(minor).append(".").append(patch);
+    if (pre_release.has_value()) {
+      result.append("-").append(*pre_release);
+    }
+    if (build.has_value()) {
+      result.append("+").append(*build);
+    }
+    return result;
+  }
 };
 
 enum parse_error {
@@ -84,6 +115,7 @@ enum parse_error {
   INVALID_MINOR,
   INVALID_PATCH,
   INVALID_RELEASE_TYPE,
+  INVALID_IDENTIFIER,
 };
 
 // This will return a cleaned and trimmed semver version.
@@ -91,31 +123,70 @@ enum parse_error {
 // This does not work for ranges.
 std::expected<version, parse_error> clean(std::string_view input);
 
-std::expected<version, parse_error> parse(std::string_view version);
+constexpr std::expected<version, parse_error> parse(std::string_view version);
 
+// The release types follow npm's semver.inc():
+// - MAJOR, MINOR, PATCH: 1.2.3 -> 2.0.0, 1.3.0, 1.2.4. A pre-release of the
+//   target version is released instead: 2.0.0-beta -> 2.0.0 for MAJOR.
+// - PRE_MAJOR, PRE_MINOR, PRE_PATCH: 1.2.3 -> 2.0.0-0, 1.3.0-0, 1.2.4-0.
+// - PRE_RELEASE: bumps the last numeric pre-release identifier
+//   (1.2.3-beta.1 -> 1.2.3-beta.2), or starts a pre-release of the next patch
+//   (1.2.3 -> 1.2.4-0).
+// - RELEASE: drops the pre-release, 1.2.3-beta.1 -> 1.2.3.
 enum release_type {
   MAJOR,
   MINOR,
   PATCH,
-  // TODO: also support
-  //  - PRE_MAJOR
-  //  - PRE_MINOR
-  //  - PRE_PATCH
-  //  - PRE_RELEASE
-  //  - RELEASE
+  PRE_MAJOR,
+  PRE_MINOR,
+  PRE_PATCH,
+  PRE_RELEASE,
+  RELEASE,
+};
+
+// The counter that starts a new pre-release: "beta.0", "beta.1" or no counter
+// at all ("beta", which requires an identifier).
+enum identifier_base {
+  BASE_ZERO,
+  BASE_ONE,
+  BASE_NONE,
+};
+
+// Fixed-capacity output for inc(), so that bumping versions in bulk does not
+// allocate.
+struct version_buffer {
+  char data[MAX_VERSION_LENGTH];
+  size_t size = 0;
+
+  constexpr std::string_view view() const noexcept { return {data, size}; }
 };
 
+// Increment the version according to the provided release type, writing the
+// result into `output` and returning a view of it. For the PRE_* types,
+// `identifier` names the pre-release (PRE_MINOR with "beta" gives 1.3.0-beta.0)
+// and `base` picks the first counter. Build metadata is dropped.
+std::expected<std::string_view, parse_error> inc(
+    const version& input, release_type release_type, version_buffer& output,
+    std::string_view identifier = {}, identifier_base base = BASE_ZERO);
+
 // Increment the version according to the provided release type.
 std::expected<std::string, parse_error> inc(version input,
-                                            release_type release_type);
+                                            release_type release_type,
+                                            std::string_view identifier = {},
+                                            identifier_base base = BASE_ZERO);
+std::expected<std::pmr::string, parse_error> inc(
+    const version& input, release_type release_type,
+    std::pmr::memory_resource* resource, std::string_view identifier = {},
+    identifier_base base = BASE_ZERO);
 
 inline std::expected<std::string, parse_error> increment(
-    std::string_view input, release_type release_type) {
+    std::string_view input, release_type release_type,
+    std::string_view identifier = {}, identifier_base base = BASE_ZERO) {
   auto parts = parse(input);
   if (!parts.has_value()) {
     return std::unexpected(parts.error());
   }
-  return inc(parts.value(), release_type);
+  return inc(parts.value(), release_type, identifier, base);
 }
 
 inline std::expected<std::string, parse_error> operator+(
@@ -128,11 +199,578 @@ inline std::expected<std::string, parse_error> operator+(
   return operator+(std::string_view(lhs), rhs);
 }
 
-}  // namespace version_weaver
+struct coerce_options {
+  // As npm's rtl option: take the version that ends last, rather than the
+  // one that starts first, so that "1.2.3.4" gives 2.3.4 rather than 1.2.3.
+  bool rtl = false;
+};
 
-// https://semver.org/#spec-item-11
-inline auto operator<=>(const version_weaver::version& first,
-                        const version_weaver::version& second) {
+std::optional<std::string> coerce(std::string_view version,
+                                  coerce_options options);
+std::optional<std::pmr::string> coerce(std::string_view version,
+                                       coerce_options options,
+                                       std::pmr::memory_resource* resource);
+
+// A version found in free-form text: the digits and dots at
+// [offset, offset + length), and the version they stand for. Its components
+// view the text, without leading zeroes, or are "0" when missing.
+struct coerced_version {
+  size_t offset = 0;
+  size_t length = 0;
+  version normalized;
+};
+
+// Every version that coerce() would find in `text`, scanning on after each
+// one, as in "node/v18.17.1 linux" or "Chrome 120.0.6099.129" (120.0.6099,
+// then 129.0.0). With options.rtl the scan starts from the end and records
+// come out last first. `output` is cleared first; reusing it avoids
+// allocating.
+void coerce_all(std::string_view text, std::vector<coerced_version>& output,
+                coerce_options options = {});
+
+// Returns the value of a numeric version component such as "12", or
+// std::nullopt if it is empty, contains a non-digit or does not fit in 64 bits.
+constexpr std::optional<uint64_t> component_value(
+    std::string_view digits) noexcept {
+  if (digits.empty()) {
+    return std::nullopt;
+  }
+  uint64_t value = 0;
+  // Up to 19 digits always fit, so only longer components check overflow.
+  if (digits.size() < 20) {
+    for (char c : digits) {
+      if (c < '0' || c > '9') {
+        return std::nullopt;
+      }
+      value = value * 10 + uint64_t(c - '0');
+    }
+    return value;
+  }
+  for (char c : digits) {
+    if (c < '0' || c > '9') {
+      return std::nullopt;
+    }
+    uint64_t digit = uint64_t(c - '0');
+    if (value > (UINT64_MAX - digit) / 10) {
+      return std::nullopt;
+    }
+    value = value * 10 + digit;
+  }
+  return value;
+}
+
+constexpr bool is_digit(const char c) noexcept { return c >= '0' && c <= '9'; }
+
+// The characters std::isspace() accepts in the "C" locale.
+constexpr bool is_whitespace(const char c) noexcept {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+         c == '\v';
+}
+
+constexpr bool contains_only_digits(std::string_view input) noexcept {
+  return input.find_first_not_of("0123456789") == std::string_view::npos;
+}
+
+constexpr void trim_whitespace(std::string_view* input) noexcept {
+  while (!input->empty() && is_whitespace(input->front())) {
+    input->remove_prefix(1);
+  }
+  while (!input->empty() && is_whitespace(input->back())) {
+    input->remove_suffix(1);
+  }
+}
+
+constexpr std::expected<version, parse_error> parse(std::string_view input) {
+  if (input.size() > MAX_VERSION_LENGTH) {
+    return std::unexpected(parse_error::VERSION_LARGER_THAN_MAX_LENGTH);
+  }
+
+  std::string_view input_copy = input;
+  trim_whitespace(&input_copy);
+
+  auto dot_iterator = input_copy.find('.');
+  if (dot_iterator == std::string_view::npos) {
+    // Only major exists. No minor or patch.
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  version version;
+  auto major = input_copy.substr(0, dot_iterator);
+
+  if (major.empty() || major.front() == '0') {
+    // Version components can not have leading zeroes.
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  if (!contains_only_digits(major)) {
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  version.major = major;
+  input_copy = input_copy.substr(dot_iterator + 1);
+  dot_iterator = input_copy.find('.');
+  if (dot_iterator == std::string_view::npos) {
+    // Only major and minor exists. No patch.
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+
+  auto minor = input_copy.substr(0, dot_iterator);
+  if (minor.empty() || (minor.front() == '0' && minor.size() > 1)) {
+    // Version components can not have leading zeroes.
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  if (!contains_only_digits(minor)) {
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  version.minor = minor;
+  input_copy = input_copy.substr(dot_iterator + 1);
+  dot_iterator = input_copy.find_first_of("-+");
+  auto patch = (dot_iterator == std::string_view::npos)
+                   ? input_copy
+                   : input_copy.substr(0, dot_iterator);
+  if (patch.empty() || (patch.front() == '0' && patch.size() > 1)) {
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  if (!contains_only_digits(patch)) {
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  version.patch = patch;
+
+  if (dot_iterator == std::string_view::npos) {
+    return version;
+  }
+  bool is_pre_release = input_copy[dot_iterator] == '-';
+  input_copy = input_copy.substr(dot_iterator + 1);
+  if (is_pre_release) {
+    dot_iterator = input_copy.find('+');
+    auto prerelease = (dot_iterator == std::string_view::npos)
+                          ? input_copy
+                          : input_copy.substr(0, dot_iterator);
+    if (prerelease.empty()) {
+      return std::unexpected(parse_error::INVALID_INPUT);
+    }
+    version.pre_release = prerelease;
+    if (dot_iterator == std::string_view::npos) {
+      return version;
+    }
+    input_copy = input_copy.substr(dot_iterator + 1);
+  }
+  if (input_copy.empty()) {
+    return std::unexpected(parse_error::INVALID_INPUT);
+  }
+  version.build = input_copy;
+  return version;
+}
+
+// Drops the leading zeroes of a run of digits, keeping a single "0".
+constexpr std::string_view trim_leading_zeroes(std::string_view digits) noexcept {
+  while (digits.size() > 1 && digits.front() == '0') {
+    digits.remove_prefix(1);
+  }
+  return digits;
+}
+
+// Checks a pre-release: dot-separated, non-empty identifiers made of
+// [0-9A-Za-z-], numeric ones without leading zeroes.
+constexpr bool valid_pre_release(std::string_view pre_release) noexcept {
+  size_t start = 0;
+  while (true) {
+    size_t end = pre_release.find('.', start);
+    std::string_view identifier = pre_release.substr(
+        start, end == std::string_view::npos ? end : end - start);
+    if (identifier.empty()) return false;
+    bool numeric = true;
+    for (char c : identifier) {
+      if (!is_digit(c) && !(c >= 'a' && c <= 'z') && !(c >= 'A' && c <= 'Z') &&
+          c != '-') {
+        return false;
+      }
+      numeric = numeric && is_digit(c);
+    }
+    if (numeric && identifier.size() > 1 && identifier.front() == '0') {
+      return false;
+    }
+    if (end == std::string_view::npos) return true;
+    start = end + 1;
+  }
+}
+
+// A version component produced by arithmetic on digit strings. The digits are
+// held inline so that bumping a version never allocates.
+struct component_buffer {
+  char data[MAX_VERSION_LENGTH + 1]{};
+  size_t size = 0;
+
+  constexpr std::string_view view() const noexcept { return {data, size}; }
+};
+
+constexpr component_buffer component_from_value(uint64_t value) noexcept {
+  component_buffer result;
+  char reversed[20]{};
+  size_t count = 0;
+  do {
+    reversed[count++] = char('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (count > 0) {
+    result.data[result.size++] = reversed[--count];
+  }
+  return result;
+}
+
+// Adds one to a numeric component of any length, dropping leading zeroes:
+// "9" -> "10", "18446744073709551615" -> "18446744073709551616". Values below
+// 2^64 - 1 take a 64-bit fast path; wider ones propagate the carry over the
+// digits. Returns std::nullopt for an empty or non-numeric component, or one
+// longer than MAX_VERSION_LENGTH.
+constexpr std::optional<component_buffer> increment_component(
+    std::string_view digits) noexcept {
+  auto value = component_value(digits);
+  if (value.has_value() && *value != UINT64_MAX) {
+    return component_from_value(*value + 1);
+  }
+  digits = trim_leading_zeroes(digits);
+  if (digits.empty() || digits.size() > MAX_VERSION_LENGTH) {
+    return std::nullopt;
+  }
+  component_buffer result;
+  result.size = digits.size();
+  bool carry = true;
+  for (size_t i = digits.size(); i-- > 0;) {
+    if (!is_digit(digits[i])) {
+      return std::nullopt;
+    }
+    char c = carry ? char(digits[i] + 1) : digits[i];
+    carry = c > '9';
+    result.data[i] = carry ? '0' : c;
+  }
+  if (carry) {
+    // All nines: shift right to make room for the leading one.
+    for (size_t i = result.size; i > 0; i--) {
+      result.data[i] = result.data[i - 1];
+    }
+    result.data[0] = '1';
+    result.size++;
+  }
+  return result;
+}
+
+// Subtracts one from a numeric component of any length, dropping leading
+// zeroes: "10" -> "9". Returns std::nullopt for zero, or for an empty,
+// non-numeric or too long component.
+constexpr std::optional<component_buffer> decrement_component(
+    std::string_view digits) noexcept {
+  auto value = component_value(digits);
+  if (value.has_value()) {
+    if (*value == 0) {
+      return std::nullopt;
+    }
+    return component_from_value(*value - 1);
+  }
+  digits = trim_leading_zeroes(digits);
+  if (digits.empty() || digits.size() > MAX_VERSION_LENGTH) {
+    return std::nullopt;
+  }
+  component_buffer result;
+  result.size = digits.size();
+  bool borrow = true;
+  for (size_t i = digits.size(); i-- > 0;) {
+    if (!is_digit(digits[i])) {
+      return std::nullopt;
+    }
+    char c = borrow ? char(digits[i] - 1) : digits[i];
+    borrow = c < '0';
+    result.data[i] = borrow ? '9' : c;
+  }
+  // Wide values are never zero, so there is no final borrow; "1000" becomes
+  // "0999", which loses its leading zero.
+  if (result.data[0] == '0') {
+    for (size_t i = 0; i + 1 < result.size; i++) {
+      result.data[i] = result.data[i + 1];
+    }
+    result.size--;
+  }
+  return result;
+}
+
+// Compares dot-separated pre-release identifiers, stopping at the end of
+// either string or at a '+' (build metadata). Identifiers made of digits
+// compare numerically and rank below alphanumeric ones, which compare in
+// ASCII order; when all shared identifiers are equal, the longer list ranks
+// higher. https://semver.org/#spec-item-11
+constexpr std::strong_ordering compare_identifiers(
+    std::string_view first, std::string_view second) noexcept {
+  size_t i = 0;
+  size_t j = 0;
+  while (true) {
+    bool first_numeric = true;
+    bool second_numeric = true;
+    size_t first_length = 0;
+    size_t second_length = 0;
+    std::strong_ordering bytes = std::strong_ordering::equal;
+    // Walk both identifiers in lockstep, remembering the first differing
+    // byte and whether each is numeric.
+    while (true) {
+      bool first_more =
+          i < first.size() && first[i] != '.' && first[i] != '+';
+      bool second_more =
+          j < second.size() && second[j] != '.' && second[j] != '+';
+      if (!first_more && !second_more) {
+        break;
+      }
+      if (first_more) {
+        first_numeric = first_numeric && is_digit(first[i]);
+        first_length++;
+      }
+      if (second_more) {
+        second_numeric = second_numeric && is_digit(second[j]);
+        second_length++;
+      }
+      if (first_more && second_more && bytes == 0) {
+        bytes = uint8_t(first[i]) <=> uint8_t(second[j]);
+      }
+      i += first_more;
+      j += second_more;
+    }
+    first_numeric = first_numeric && first_length > 0;
+    second_numeric = second_numeric && second_length > 0;
+    if (first_numeric != second_numeric) {
+      return first_numeric ? std::strong_ordering::less
+                           : std::strong_ordering::greater;
+    }
+    if (first_numeric && first_length != second_length) {
+      return first_length <=> second_length;
+    }
+    if (bytes != 0) {
+      return bytes;
+    }
+    if (first_length != second_length) {
+      return first_length <=> second_length;
+    }
+    bool first_done = i >= first.size() || first[i] == '+';
+    bool second_done = j >= second.size() || second[j] == '+';
+    if (first_done || second_done) {
+      return !second_done  ? std::strong_ordering::less
+             : !first_done ? std::strong_ordering::greater
+                           : std::strong_ordering::equal;
+    }
+    i++;
+    j++;
+  }
+}
+
+// Compares two version strings by precedence in a single left-to-right pass
+// over both, without allocating or converting numbers, so components of any
+// length are supported. Build metadata is ignored. Missing minor or patch
+// components (as in range bounds such as "<2") count as zero. The input is
+// not validated: use parse() first when that matters.
+constexpr std::strong_ordering compare(std::string_view first,
+                                       std::string_view second) noexcept {
+  size_t i = 0;
+  size_t j = 0;
+  for (int component = 0; component < 3; component++) {
+    // Leading zeroes do not change the value; an empty run is zero.
+    while (i < first.size() && first[i] == '0') {
+      i++;
+    }
+    while (j < second.size() && second[j] == '0') {
+      j++;
+    }
+    // The longer run of digits is the larger number; for equal lengths the
+    // first differing digit decides.
+    std::strong_ordering digits = std::strong_ordering::equal;
+    while (true) {
+      bool first_more = i < first.size() && is_digit(first[i]);
+      bool second_more = j < second.size() && is_digit(second[j]);
+      if (first_more != second_more) {
+        return first_more ? std::strong_ordering::greater
+                          : std::strong_ordering::less;
+      }
+      if (!first_more) {
+        break;
+      }
+      if (digits == 0) {
+        digits = first[i] <=> second[j];
+      }
+      i++;
+      j++;
+    }
+    if (digits != 0) {
+      return digits;
+    }
+    if (component < 2) {
+      i += i < first.size() && first[i] == '.';
+      j += j < second.size() && second[j] == '.';
+    }
+  }
+  bool first_pre_release = i < first.size() && first[i] == '-';
+  bool second_pre_release = j < second.size() && second[j] == '-';
+  if (first_pre_release != second_pre_release) {
+    return first_pre_release ? std::strong_ordering::less
+                             : std::strong_ordering::greater;
+  }
+  if (!first_pre_release) {
+    return std::strong_ordering::equal;
+  }
+  return compare_identifiers(first.substr(i + 1), second.substr(j + 1));
+}
+
+// Spans at least this long are split across threads by sort_versions() when
+// more than one thread is allowed.
+static constexpr size_t PARALLEL_SORT_THRESHOLD = 1 << 16;
+
+// Sorts versions by precedence, lowest first, in the order defined by
+// operator<=>. Versions of equal precedence keep their relative order.
+// Release triples are radix sorted on packed integer keys, and only runs of
+// pre-releases sharing a triple fall back to comparison-based merging. Spans
+// longer than PARALLEL_SORT_THRESHOLD are sorted on up to `threads` threads.
+void sort_versions(std::span<version> versions, size_t threads = 1);
+
+// Removes all but the first version of every run of equal precedence from a
+// sorted span, like std::unique. Build metadata is ignored. Returns the number
+// of versions kept, which are moved to the front of the span.
+size_t unique_versions(std::span<version> versions);
+
+enum release_line_kind {
+  MAJOR_LINE,
+  MINOR_LINE,
+};
+
+// A release line of a sorted span, such as every 2.x or every 2.3.x version:
+// the versions at [begin, end). `latest` is the highest of them that is not a
+// pre-release, or the highest of all when the line only has pre-releases.
+struct release_line {
+  size_t begin;
+  size_t end;
+  size_t latest;
+};
+
+// The major or minor release lines of a sorted span, lowest first. The end of
+// each line is found by exponential search, so a package with many releases
+// per line takes O(lines * log n) comparisons rather than one per version.
+std::vector<release_line> release_lines(std::span<const version> sorted,
+                                        release_line_kind kind);
+
+// The line of `major`, or of `major`.`minor`, in a sorted span, found by
+// binary search. Components are compared numerically.
+std::optional<release_line> find_release_line(
+    std::span<const version> sorted, std::string_view major,
+    std::optional<std::string_view> minor = std::nullopt);
+
+// Hashes `bytes` into `seed`. The length is mixed in, so that consecutive
+// fields hash differently from their concatenation. Words are assembled byte
+// by byte to stay usable in constant expressions; compilers turn this into
+// plain 64-bit loads.
+constexpr uint64_t hash_bytes(std::string_view bytes, uint64_t seed) noexcept {
+  constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+  constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+  constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+  uint64_t h = seed ^ ((uint64_t(bytes.size()) + 1) * prime1);
+  size_t i = 0;
+  for (; i + 8 <= bytes.size(); i += 8) {
+    uint64_t word = 0;
+    for (size_t j = 0; j < 8; j++) {
+      word |= uint64_t(uint8_t(bytes[i + j])) << (8 * j);
+    }
+    h ^= std::rotl(word * prime2, 31) * prime1;
+    h = std::rotl(h, 27) * prime1 + prime3;
+  }
+  if (i < bytes.size()) {
+    uint64_t word = 0;
+    for (size_t j = 0; i + j < bytes.size(); j++) {
+      word |= uint64_t(uint8_t(bytes[i + j])) << (8 * j);
+    }
+    h ^= std::rotl(word * prime2, 31) * prime1;
+    h = std::rotl(h, 27) * prime1 + prime3;
+  }
+  return h;
+}
+
+constexpr uint64_t hash_finalize(uint64_t h) noexcept {
+  h ^= h >> 33;
+  h *= 0xC2B2AE3D27D4EB4FULL;
+  h ^= h >> 29;
+  h *= 0x165667B19E3779F9ULL;
+  h ^= h >> 32;
+  return h;
+}
+
+// Hash consistent with precedence: versions that compare equal with == (which
+// ignores build metadata) have the same hash. This is what std::hash uses.
+constexpr uint64_t precedence_hash(const version& v) noexcept {
+  uint64_t h = hash_bytes(v.major, 0);
+  h = hash_bytes(v.minor, h);
+  h = hash_bytes(v.patch, h);
+  if (v.pre_release.has_value()) {
+    h = hash_bytes(v.pre_release.value(), h ^ 1);
+  }
+  return hash_finalize(h);
+}
+
+// Precedence equality: build metadata is ignored, so this holds exactly when
+// operator<=> returns equal.
+constexpr bool operator==(const version& first, const version& second) noexcept {
+  return first.major == second.major && first.minor == second.minor &&
+         first.patch == second.patch &&
+         first.pre_release == second.pre_release;
+}
+
+// Exact identity: two versions are identical when every field, build
+// metadata included, is the same.
+constexpr bool identical(const version& first, const version& second) noexcept {
+  return first.major == second.major && first.minor == second.minor &&
+         first.patch == second.patch &&
+         first.pre_release == second.pre_release &&
+         first.build == second.build;
+}
+
+// Hash consistent with identical().
+constexpr uint64_t identity_hash(const version& v) noexcept {
+  uint64_t h = hash_bytes(v.major, 0);
+  h = hash_bytes(v.minor, h);
+  h = hash_bytes(v.patch, h);
+  if (v.pre_release.has_value()) {
+    h = hash_bytes(v.pre_release.value(), h ^ 1);
+  }
+  if (v.build.has_value()) {
+    h = hash_bytes(v.build.value(), h ^ 2);
+  }
+  return hash_finalize(h);
+}
+
+// Hash and key-equal functors for containers keyed on exact identity, e.g.
+// std::unordered_set<version, version_identity_hash, version_identity_equal>.
+struct version_identity_hash {
+  size_t operator()(const version& v) const noexcept {
+    return size_t(identity_hash(v));
+  }
+};
+
+struct version_identity_equal {
+  bool operator()(const version& first, const version& second) const noexcept {
+    return identical(first, second);
+  }
+};
+
+// Orders the pre-release parts of two versions with the same major, minor
+// and patch; a version without a pre-release ranks above one with a
+// pre-release.
+constexpr std::strong_ordering compare_pre_release(
+    std::optional<std::string_view> first,
+    std::optional<std::string_view> second) noexcept {
+  if (second.has_value() && !first.has_value()) {
+    return std::strong_ordering::greater;
+  }
+  if (first.has_value() && !second.has_value()) {
+    return std::strong_ordering::less;
+  }
+  if (!first.has_value() && !second.has_value()) {
+    return std::strong_ordering::equal;
+  }
+  return compare_identifiers(first.value(), second.value());
+}
+
+// Orders the major, minor and patch of two versions, whose components have
+// no leading zeroes.
+constexpr std::strong_ordering compare_release(const version& first,
+                                               const version& second) noexcept {
   auto number_string_compare = [](std::string_view first,
                                   std::string_view second) {
     if (first.size() > second.size()) {
@@ -158,48 +796,345 @@ inline auto operator<=>(const version_weaver::version& first,
   if (first.patch != second.patch) {
     return number_string_compare(first.patch, second.patch);
   }
-  if (second.pre_release.has_value() && !first.pre_release.has_value()) {
-    return std::strong_ordering::greater;
+  return std::strong_ordering::equal;
+}
+
+// https://semver.org/#spec-item-11
+constexpr std::strong_ordering operator<=>(const version& first,
+                                           const version& second) noexcept {
+  auto release = compare_release(first, second);
+  if (release != 0) {
+    return release;
   }
-  if (first.pre_release.has_value() && !second.pre_release.has_value()) {
-    return std::strong_ordering::less;
+  return compare_pre_release(first.pre_release, second.pre_release);
+}
+
+// The change from the lower of two versions to the higher one, as npm's
+// semver.diff(): MAJOR, MINOR or PATCH for the first component that differs,
+// or PRE_MAJOR, PRE_MINOR or PRE_PATCH when the higher version is a
+// pre-release, and PRE_RELEASE when only the pre-releases differ. A
+// pre-release followed by its own release is a change of its last non-zero
+// component: 1.2.0-beta -> 1.2.0 is MINOR, and 1.0.0-beta -> 1.1.1 is MAJOR.
+// std::nullopt for versions of equal precedence. Components compare as
+// strings, since valid ones have no leading zeroes.
+constexpr std::optional<release_type> diff(const version& first,
+                                           const version& second) noexcept {
+  auto order = first <=> second;
+  if (order == 0) {
+    return std::nullopt;
   }
-  if (!first.pre_release.has_value() && !second.pre_release.has_value()) {
-    return std::strong_ordering::equal;
+  const version& high = order > 0 ? first : second;
+  const version& low = order > 0 ? second : first;
+  bool same_major = first.major == second.major;
+  bool same_minor = same_major && first.minor == second.minor;
+  bool same_patch = same_minor && first.patch == second.patch;
+  bool high_pre_release = high.pre_release.has_value();
+  if (low.pre_release.has_value() && !high_pre_release) {
+    if (low.minor == "0" && low.patch == "0") {
+      return MAJOR;
+    }
+    if (same_patch) {
+      return low.patch == "0" ? MINOR : PATCH;
+    }
   }
-  if (first.pre_release.value() == second.pre_release.value()) {
-    return std::strong_ordering::equal;
+  if (!same_major) {
+    return high_pre_release ? PRE_MAJOR : MAJOR;
   }
-  auto only_digits = [](std::string_view first) {
-    for (auto c : first) {
-      if (c < '0' || c > '9') {
+  if (!same_minor) {
+    return high_pre_release ? PRE_MINOR : MINOR;
+  }
+  if (!same_patch) {
+    return high_pre_release ? PRE_PATCH : PATCH;
+  }
+  return PRE_RELEASE;
+}
+
+// diff() of two version strings, which must be valid.
+constexpr std::expected<std::optional<release_type>, parse_error> diff(
+    std::string_view first, std::string_view second) {
+  auto first_version = parse(first);
+  if (!first_version.has_value()) {
+    return std::unexpected(first_version.error());
+  }
+  auto second_version = parse(second);
+  if (!second_version.has_value()) {
+    return std::unexpected(second_version.error());
+  }
+  return diff(*first_version, *second_version);
+}
+
+// Interns pre-release identifiers to small integers, for catalogs with many
+// pre-releases. Numeric identifiers below 2^31 are stored as their value;
+// every other identifier is interned once and ranked among the others in the
+// order of compare_identifiers(). Comparing two interned pre-releases then
+// compares short arrays of integers rather than bytes. Interning and
+// comparing may alternate: identifiers added since the last ranking compare
+// by text, and are ranked in one batch once there are enough of them.
+class pre_release_table {
+ public:
+  // An interned pre-release. The default value stands for no pre-release.
+  struct id {
+    uint32_t offset = 0;
+    uint32_t size = 0;
+  };
+
+  // The pre-release must be valid, as after parse().
+  id intern(std::optional<std::string_view> pre_release);
+
+  // The order of compare_pre_release() on the interned strings.
+  std::strong_ordering compare(id first, id second) const noexcept;
+  // The order of operator<=>, when `first_id` and `second_id` were interned
+  // from the pre-releases of `first` and `second`.
+  std::strong_ordering compare(const version& first, id first_id,
+                               const version& second,
+                               id second_id) const noexcept {
+    auto release = compare_release(first, second);
+    return release != 0 ? release : compare(first_id, second_id);
+  }
+
+  // Number of distinct identifiers interned by name.
+  size_t symbol_count() const noexcept { return symbols_.size(); }
+
+ private:
+  static constexpr uint32_t SYMBOL = uint32_t(1) << 31;
+  static constexpr uint32_t UNRANKED = UINT32_MAX;
+
+  // Hashes std::string keys and std::string_view lookups alike.
+  struct text_hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view text) const noexcept {
+      return std::hash<std::string_view>{}(text);
+    }
+  };
+
+  uint32_t intern_identifier(std::string_view identifier);
+  void rank_symbols();
+
+  // Every interned pre-release, and every interned identifier by name.
+  std::unordered_map<std::string, id, text_hash, std::equal_to<>>
+      pre_releases_;
+  std::unordered_map<std::string, uint32_t, text_hash, std::equal_to<>>
+      symbols_;
+  std::vector<std::string_view> symbol_text_;
+  // Ranked symbols in identifier order, and the position of each symbol in
+  // it. Symbols interned since the last ranking are UNRANKED and compare by
+  // text, until there are enough of them to rank every symbol again.
+  std::vector<uint32_t> order_;
+  std::vector<uint32_t> ranks_;
+  std::vector<uint32_t> unranked_;
+  // The keys of every interned pre-release, back to back.
+  std::vector<uint32_t> keys_;
+};
+
+// A version string decoded on demand. Each part is located and validated
+// with the rules of parse() the first time it is needed, and remembered, so
+// that a comparison decided by the major version never looks past the first
+// dot. Since the rest of the string is not looked at, an invalid suffix only
+// surfaces when the parts it holds are requested; use to_version() to
+// validate everything.
+//
+// The const accessors decode into mutable members without synchronization,
+// so a lazy_version is not safe to use from several threads at once, even
+// through a const reference. Give each thread its own copy, or share the
+// result of to_version() instead.
+class lazy_version {
+ public:
+  constexpr explicit lazy_version(std::string_view input) noexcept
+      : input_(input) {}
+
+  constexpr std::expected<std::string_view, parse_error> major() const noexcept {
+    return component(0);
+  }
+  constexpr std::expected<std::string_view, parse_error> minor() const noexcept {
+    return component(1);
+  }
+  constexpr std::expected<std::string_view, parse_error> patch() const noexcept {
+    return component(2);
+  }
+  constexpr std::expected<std::optional<std::string_view>, parse_error>
+  pre_release() const noexcept {
+    if (!decode(4)) {
+      return std::unexpected(error_);
+    }
+    return pre_release_;
+  }
+  constexpr std::expected<std::optional<std::string_view>, parse_error> build()
+      const noexcept {
+    if (!decode(4)) {
+      return std::unexpected(error_);
+    }
+    return build_;
+  }
+
+  // Decodes everything that is left; same result as parse().
+  constexpr std::expected<version, parse_error> to_version() const noexcept {
+    if (!decode(4)) {
+      return std::unexpected(error_);
+    }
+    return version{components_[0], components_[1], components_[2],
+                   pre_release_, build_};
+  }
+
+  // The number of parts decoded so far: 0 to 3 for major, minor and patch,
+  // 4 once pre-release and build are known too.
+  constexpr int decoded() const noexcept { return decoded_; }
+
+ private:
+  constexpr std::expected<std::string_view, parse_error> component(
+      int index) const noexcept {
+    if (!decode(index + 1)) {
+      return std::unexpected(error_);
+    }
+    return components_[index];
+  }
+
+  // Decodes parts until `count` are known. Returns false on invalid input.
+  constexpr bool decode(int count) const noexcept {
+    while (decoded_ < count) {
+      if (failed_) {
+        return false;
+      }
+      if (!decode_next()) {
+        failed_ = true;
         return false;
       }
+      decoded_++;
     }
     return true;
-  };
-  bool first_numeric = only_digits(first.pre_release.value());
-  bool second_numeric = only_digits(second.pre_release.value());
-  if (first_numeric && !second_numeric) {
-    return std::strong_ordering::greater;
   }
-  if (!first_numeric && second_numeric) {
-    return std::strong_ordering::less;
+
+  constexpr bool decode_next() const noexcept {
+    if (decoded_ == 0) {
+      if (input_.size() > MAX_VERSION_LENGTH) {
+        error_ = parse_error::VERSION_LARGER_THAN_MAX_LENGTH;
+        return false;
+      }
+      trim_whitespace(&input_);
+    }
+    error_ = parse_error::INVALID_INPUT;
+    if (decoded_ < 3) {
+      size_t start = cursor_;
+      while (cursor_ < input_.size() && is_digit(input_[cursor_])) {
+        cursor_++;
+      }
+      std::string_view digits = input_.substr(start, cursor_ - start);
+      // Components can not have leading zeroes, and the major can not be 0.
+      if (digits.empty() || (digits.front() == '0' &&
+                             (decoded_ == 0 || digits.size() > 1))) {
+        return false;
+      }
+      if (decoded_ < 2) {
+        if (cursor_ == input_.size() || input_[cursor_] != '.') {
+          return false;
+        }
+        cursor_++;
+      } else if (cursor_ < input_.size() && input_[cursor_] != '-' &&
+                 input_[cursor_] != '+') {
+        return false;
+      }
+      components_[decoded_] = digits;
+      return true;
+    }
+    std::string_view rest = input_.substr(cursor_);
+    if (rest.empty()) {
+      return true;
+    }
+    bool is_pre_release = rest.front() == '-';
+    rest.remove_prefix(1);
+    if (is_pre_release) {
+      size_t plus = rest.find('+');
+      pre_release_ = rest.substr(0, plus);
+      if (pre_release_->empty()) {
+        return false;
+      }
+      if (plus == std::string_view::npos) {
+        return true;
+      }
+      rest.remove_prefix(plus + 1);
+    }
+    if (rest.empty()) {
+      return false;
+    }
+    build_ = rest;
+    return true;
   }
-  if (first_numeric && second_numeric) {
-    return number_string_compare(first.pre_release.value(),
-                                 second.pre_release.value());
+
+  mutable std::string_view input_;
+  mutable std::string_view components_[3];
+  mutable std::optional<std::string_view> pre_release_;
+  mutable std::optional<std::string_view> build_;
+  mutable size_t cursor_ = 0;
+  mutable int decoded_ = 0;
+  mutable bool failed_ = false;
+  mutable parse_error error_ = parse_error::INVALID_INPUT;
+};
+
+// Precedence order between lazily decoded versions, decoding only what is
+// needed to decide. Unordered when a part that had to be looked at is invalid.
+constexpr std::partial_ordering operator<=>(const lazy_version& first,
+                                            const lazy_version& second) noexcept {
+  for (int i = 0; i < 3; i++) {
+    auto x = i == 0 ? first.major() : i == 1 ? first.minor() : first.patch();
+    auto y = i == 0 ? second.major() : i == 1 ? second.minor() : second.patch();
+    if (!x || !y) {
+      return std::partial_ordering::unordered;
+    }
+    if (x->size() != y->size()) {
+      return x->size() <=> y->size();
+    }
+    if (*x != *y) {
+      return *x <=> *y;
+    }
   }
-  size_t min_size = std::min(first.pre_release.value().size(),
-                             second.pre_release.value().size());
-  for (size_t i = 0; i < min_size; i++) {
-    if (first.pre_release.value()[i] > second.pre_release.value()[i]) {
-      return std::strong_ordering::greater;
-    } else if (first.pre_release.value()[i] < second.pre_release.value()[i]) {
-      return std::strong_ordering::less;
+  auto x = first.pre_release();
+  auto y = second.pre_release();
+  if (!x || !y) {
+    return std::partial_ordering::unordered;
+  }
+  return compare_pre_release(*x, *y);
+}
+
+// Precedence order against a parsed version, such as a range bound.
+constexpr std::partial_ordering operator<=>(const lazy_version& first,
+                                            const version& second) noexcept {
+  std::string_view parts[] = {second.major, second.minor, second.patch};
+  for (int i = 0; i < 3; i++) {
+    auto x = i == 0 ? first.major() : i == 1 ? first.minor() : first.patch();
+    if (!x) {
+      return std::partial_ordering::unordered;
+    }
+    if (x->size() != parts[i].size()) {
+      return x->size() <=> parts[i].size();
+    }
+    if (*x != parts[i]) {
+      return *x <=> parts[i];
     }
   }
-  return first.pre_release.value().size() <=> second.pre_release.value().size();
+  auto x = first.pre_release();
+  if (!x) {
+    return std::partial_ordering::unordered;
+  }
+  return compare_pre_release(*x, second.pre_release);
+}
+
+// Equal precedence; false when either side is invalid.
+constexpr bool operator==(const lazy_version& first,
+                          const lazy_version& second) noexcept {
+  return (first <=> second) == 0;
+}
+
+constexpr bool operator==(const lazy_version& first,
+                          const version& second) noexcept {
+  return (first <=> second) == 0;
 }
 
+}  // namespace version_weaver
+
+template <>
+struct std::hash<version_weaver::version> {
+  size_t operator()(const version_weaver::version& v) const noexcept {
+    return size_t(version_weaver::precedence_hash(v));
+  }
+};
+
 #endif  // VERSION_WEAVER_H
\ No newline at end of file
@@ -0,0 +1,248 @@
+#ifndef VERSION_WEAVER_ASYNC_RESOLVER_H
+#define VERSION_WEAVER_ASYNC_RESOLVER_H
+#include "version_weaver/resolver.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace version_weaver {
+
+// A lazily started coroutine producing a T. Awaiting the task runs it, and
+// resumes the awaiter once it has produced its value.
+template <typename T>
+class task {
+ public:
+  struct promise_type {
+    std::optional<T> value;
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+
+    task get_return_object() noexcept {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    auto final_suspend() noexcept {
+      struct final_awaiter {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<promise_type> done) noexcept {
+          return done.promise().continuation;
+        }
+        void await_resume() noexcept {}
+      };
+      return final_awaiter{};
+    }
+    void return_value(T result) { value.emplace(std::move(result)); }
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  task(task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  task& operator=(task&& other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  ~task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> awaiter) noexcept {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+  T await_resume() { return std::move(*handle_.promise().value); }
+
+ private:
+  explicit task(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Runs a task to completion, blocking the calling thread.
+template <typename T>
+T sync_wait(task<T> work) {
+  struct waiter {
+    struct promise_type {
+      std::mutex mutex;
+      std::condition_variable finished;
+      bool done = false;
+
+      waiter get_return_object() noexcept {
+        return {std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      auto final_suspend() noexcept {
+        // Signals once suspended, so that the waiting thread may destroy the
+        // coroutine as soon as it wakes up.
+        struct final_awaiter {
+          bool await_ready() noexcept { return false; }
+          void await_suspend(
+              std::coroutine_handle<promise_type> finishing) noexcept {
+            auto& promise = finishing.promise();
+            std::lock_guard lock(promise.mutex);
+            promise.done = true;
+            promise.finished.notify_one();
+          }
+          void await_resume() noexcept {}
+        };
+        return final_awaiter{};
+      }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+  };
+  std::optional<T> result;
+  auto run = [](task<T>& work, std::optional<T>& result) -> waiter {
+    result.emplace(co_await work);
+  };
+  waiter wait = run(work, result);
+  wait.handle.resume();
+  {
+    auto& promise = wait.handle.promise();
+    std::unique_lock lock(promise.mutex);
+    promise.finished.wait(lock, [&promise] { return promise.done; });
+  }
+  wait.handle.destroy();
+  return std::move(*result);
+}
+
+// A small pool of threads resuming coroutines in FIFO order.
+class executor {
+ public:
+  explicit executor(size_t threads);
+  executor(const executor&) = delete;
+  executor& operator=(const executor&) = delete;
+  // Runs the coroutines still queued, then joins the threads.
+  ~executor();
+
+  // Resumes `coroutine` on one of the threads.
+  void post(std::coroutine_handle<> coroutine);
+
+  // Awaiting schedule() moves the awaiting coroutine onto the pool.
+  auto schedule() noexcept {
+    struct awaiter {
+      executor& pool;
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> coroutine) {
+        pool.post(coroutine);
+      }
+      void await_resume() noexcept {}
+    };
+    return awaiter{*this};
+  }
+
+ private:
+  void run();
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<std::coroutine_handle<>> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+// Where package metadata comes from, typically a remote registry.
+class metadata_source {
+ public:
+  virtual ~metadata_source() = default;
+
+  // Starts fetching the versions of `package`, then calls `done` exactly once,
+  // from any thread, with the package or nullptr if it does not exist. Fetches
+  // may overlap. The package must stay valid as long as the source, and its
+  // dependency ranges must be valid.
+  virtual void fetch(std::string_view package,
+                     std::function<void(const registry_package*)> done) = 0;
+};
+
+// Awaiting fetch() suspends the coroutine until the metadata of `package` has
+// arrived, then resumes it on `pool` with the package, or nullptr if it does
+// not exist.
+inline auto fetch(metadata_source& source, std::string_view package,
+                  executor& pool) noexcept {
+  struct awaiter {
+    metadata_source& source;
+    std::string_view package;
+    executor& pool;
+    const registry_package* result = nullptr;
+
+    bool await_ready() noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) {
+      source.fetch(package, [this, coroutine](const registry_package* found) {
+        result = found;
+        pool.post(coroutine);
+      });
+    }
+    const registry_package* await_resume() noexcept { return result; }
+  };
+  return awaiter{source, package, pool};
+}
+
+// An in-process metadata source serving the packages of a registry, each
+// after a delay, to stand in for a remote registry. Fetches are completed by
+// a timer thread, so any number of them can be in flight.
+class registry_source : public metadata_source {
+ public:
+  using latency_function =
+      std::function<std::chrono::microseconds(std::string_view package)>;
+
+  registry_source(const registry& packages, std::chrono::microseconds latency);
+  registry_source(const registry& packages, latency_function latency);
+  registry_source(const registry_source&) = delete;
+  registry_source& operator=(const registry_source&) = delete;
+  // Completes the fetches still pending, then joins the timer thread.
+  ~registry_source() override;
+
+  void fetch(std::string_view package,
+             std::function<void(const registry_package*)> done) override;
+
+  // The number of fetches so far.
+  size_t fetch_count() const;
+  // The highest number of fetches that were in flight at once.
+  size_t max_in_flight() const;
+
+ private:
+  struct pending {
+    const registry_package* package;
+    std::function<void(const registry_package*)> done;
+  };
+  // Ordered by deadline, then by fetch order.
+  using pending_key = std::pair<std::chrono::steady_clock::time_point, size_t>;
+
+  void run();
+
+  const registry& packages_;
+  latency_function latency_;
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::map<pending_key, pending> pending_;
+  size_t fetches_ = 0;
+  size_t in_flight_ = 0;
+  size_t max_in_flight_ = 0;
+  bool stopping_ = false;
+  std::thread timer_;
+};
+
+// Resolves a manifest as resolve() does, fetching package metadata from
+// `source`. The metadata of every package the manifest can reach is fetched
+// first, with every fetch in flight as soon as a fetched package names it:
+// each (package, range) pair evaluates its range on `pool` and starts the
+// fetches of the dependencies of the satisfying versions. The manifest must
+// outlive the task.
+task<std::expected<resolution, resolve_error>> resolve_async(
+    metadata_source& source, executor& pool,
+    std::span<const dependency> manifest);
+
+}  // namespace version_weaver
+
+#endif  // VERSION_WEAVER_ASYNC_RESOLVER_H
@@ -0,0 +1,187 @@
+#ifndef VERSION_WEAVER_CATALOG_H
+#define VERSION_WEAVER_CATALOG_H
+#include "version_weaver.h"
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace version_weaver {
+
+// A catalog is an on-disk index of pre-parsed, pre-sorted versions grouped by
+// package. It is designed to be memory-mapped and read in place: opening one
+// does not parse or copy anything.
+//
+// Layout (little-endian, every section starts on an 8-byte boundary):
+//
+//   catalog_header
+//   catalog_package[package_count]   sorted by name
+//   uint64_t major[version_count]    numeric columns, UINT64_MAX when a
+//   uint64_t minor[version_count]    component does not fit (see
+//   uint64_t patch[version_count]    CATALOG_RECORD_WIDE)
+//   catalog_record[version_count]    per package, sorted by precedence
+//   heap                             package names and version strings
+//
+// The checksum covers every byte after the header.
+static constexpr uint32_t CATALOG_FORMAT_VERSION = 1;
+
+enum catalog_error {
+  CATALOG_IO_ERROR,
+  CATALOG_TRUNCATED,
+  CATALOG_BAD_MAGIC,
+  CATALOG_UNSUPPORTED_FORMAT,
+  CATALOG_CORRUPT,
+  CATALOG_CHECKSUM_MISMATCH,
+  CATALOG_INVALID_VERSION,
+};
+
+struct catalog_header {
+  char magic[8];
+  uint32_t format_version;
+  // 0x01020304 as written by the producing host, to detect byte order.
+  uint32_t byte_order;
+  uint64_t package_count;
+  uint64_t version_count;
+  uint64_t directory_offset;
+  uint64_t columns_offset;
+  uint64_t records_offset;
+  uint64_t heap_offset;
+  uint64_t heap_size;
+  uint64_t checksum;
+};
+static_assert(sizeof(catalog_header) == 80);
+
+struct catalog_package {
+  uint64_t name_offset;
+  uint64_t name_length;
+  uint64_t first_version;
+  uint64_t version_count;
+};
+static_assert(sizeof(catalog_package) == 32);
+
+enum catalog_record_flags : uint16_t {
+  CATALOG_RECORD_PRE_RELEASE = 1,
+  CATALOG_RECORD_BUILD = 2,
+  // At least one numeric column holds UINT64_MAX because the component is
+  // wider than 64 bits; the text is authoritative.
+  CATALOG_RECORD_WIDE = 4,
+};
+
+// Locates the canonical text of a version in the heap, and the length of
+// each of its fields within it.
+struct catalog_record {
+  uint64_t text_offset;
+  uint16_t text_length;
+  uint16_t major_length;
+  uint16_t minor_length;
+  uint16_t patch_length;
+  uint16_t pre_release_length;
+  uint16_t flags;
+  uint32_t reserved;
+};
+static_assert(sizeof(catalog_record) == 24);
+
+// The versions of one package, in precedence order. Versions are views into
+// the catalog bytes, which must outlive them.
+class package_view {
+ public:
+  package_view() = default;
+  std::string_view name() const noexcept { return name_; }
+  size_t size() const noexcept { return records_.size(); }
+  bool empty() const noexcept { return records_.empty(); }
+  // `index` must be less than size().
+  version operator[](size_t index) const noexcept;
+  // Numeric columns, parallel to the versions.
+  std::span<const uint64_t> majors() const noexcept { return majors_; }
+  std::span<const uint64_t> minors() const noexcept { return minors_; }
+  std::span<const uint64_t> patches() const noexcept { return patches_; }
+  std::span<const catalog_record> records() const noexcept { return records_; }
+
+ private:
+  friend class catalog_view;
+  std::string_view name_;
+  std::span<const uint64_t> majors_;
+  std::span<const uint64_t> minors_;
+  std::span<const uint64_t> patches_;
+  std::span<const catalog_record> records_;
+  std::string_view heap_;
+};
+
+// Read-only access to catalog bytes, for example from a mapped_file.
+//
+// Lookups do not require validate(). On a catalog that fails it they never
+// read outside the bytes, but may return truncated names and versions, or
+// fewer versions than a package declares.
+class catalog_view {
+ public:
+  // Checks the header and the section bounds, in constant time. The bytes
+  // must be 8-byte aligned, which mmap and heap allocations guarantee.
+  static std::expected<catalog_view, catalog_error> open(
+      std::span<const std::byte> bytes);
+
+  // Full validation: every offset and length is in bounds, packages and
+  // versions are in order and the checksum matches. Linear in the file size.
+  std::expected<void, catalog_error> validate() const;
+
+  size_t package_count() const noexcept { return packages_.size(); }
+  size_t version_count() const noexcept { return records_.size(); }
+  // `index` must be less than package_count().
+  package_view package(size_t index) const noexcept;
+  // Binary search in the package directory.
+  std::optional<package_view> find(std::string_view name) const noexcept;
+
+ private:
+  std::span<const std::byte> bytes_;
+  std::span<const catalog_package> packages_;
+  std::span<const uint64_t> majors_;
+  std::span<const uint64_t> minors_;
+  std::span<const uint64_t> patches_;
+  std::span<const catalog_record> records_;
+  std::string_view heap_;
+};
+
+// Collects versions per package and serializes them into a catalog.
+class catalog_writer {
+ public:
+  // Adds versions to a package, which may be added several times. Versions
+  // are validated with parse(); nothing is added if one is invalid.
+  std::expected<void, catalog_error> add(
+      std::string_view package, std::span<const std::string_view> versions);
+  std::expected<void, catalog_error> add(std::string_view package,
+                                         std::span<const version> versions);
+
+  std::vector<std::byte> finish() const;
+  std::expected<void, catalog_error> write(const std::string& path) const;
+
+ private:
+  std::map<std::string, std::vector<std::string>, std::less<>> packages_;
+};
+
+// A read-only memory mapping of a whole file.
+class mapped_file {
+ public:
+  static std::expected<mapped_file, catalog_error> open(
+      const std::string& path);
+
+  mapped_file(mapped_file&& other) noexcept;
+  mapped_file& operator=(mapped_file&& other) noexcept;
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+  ~mapped_file();
+
+  std::span<const std::byte> bytes() const noexcept {
+    return {static_cast<const std::byte*>(data_), size_};
+  }
+
+ private:
+  mapped_file() = default;
+  void* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  void* mapping_ = nullptr;
+#endif
+};
+
+}  // namespace version_weaver
+
+#endif  // VERSION_WEAVER_CATALOG_H
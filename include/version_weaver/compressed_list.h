@@ -0,0 +1,92 @@
+#ifndef VERSION_WEAVER_COMPRESSED_LIST_H
+#define VERSION_WEAVER_COMPRESSED_LIST_H
+#include "version_weaver.h"
+
+#include <vector>
+
+namespace version_weaver {
+
+// A version whose numeric components are held as integers, as decoded from a
+// compressed_version_list. Pre-release and build are views into the list.
+struct packed_version {
+  uint64_t major = 0;
+  uint64_t minor = 0;
+  uint64_t patch = 0;
+  std::optional<std::string_view> pre_release;
+  std::optional<std::string_view> build;
+
+  operator std::string() const;
+};
+
+// Precedence order, consistent with operator<=> on version.
+std::strong_ordering compare(const packed_version& first,
+                             const version& second) noexcept;
+
+// An immutable, sorted list of versions stored as compressed blocks.
+//
+// Every block of BLOCK_SIZE entries starts with an absolute entry; the others
+// only store what changed since the previous entry, as LEB128 varints: the
+// patch delta when major and minor are unchanged, the minor delta and the
+// patch when only the major is unchanged, or the major delta, minor and patch
+// otherwise. Pre-release and build strings are stored inline. Consecutive
+// versions of a package typically take two or three bytes.
+//
+// A skip index holds the byte offset of every block, so that lookups binary
+// search the first entries of the blocks and then decode a single block.
+class compressed_version_list {
+ public:
+  static constexpr size_t BLOCK_SIZE = 64;
+
+  // The versions must be sorted by precedence and their components must fit
+  // in 64 bits.
+  static std::expected<compressed_version_list, parse_error> encode(
+      std::span<const version> sorted);
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  // Bytes used by the encoded entries and the skip index.
+  size_t byte_size() const noexcept {
+    return bytes_.size() + block_offsets_.size() * sizeof(uint64_t);
+  }
+
+  // Sequential decoder over the list.
+  class cursor {
+   public:
+    bool done() const noexcept { return index_ >= list_->size_; }
+    size_t index() const noexcept { return index_; }
+    const packed_version& operator*() const noexcept { return current_; }
+    const packed_version* operator->() const noexcept { return &current_; }
+    void next() noexcept;
+
+   private:
+    friend class compressed_version_list;
+    const compressed_version_list* list_ = nullptr;
+    size_t index_ = 0;
+    size_t offset_ = 0;
+    packed_version current_;
+  };
+
+  // Decodes from the start of the block holding `index`.
+  cursor at(size_t index) const noexcept;
+  cursor begin() const noexcept { return at(0); }
+  packed_version operator[](size_t index) const noexcept { return *at(index); }
+
+  // Index of the first entry not lower than `v` (lower_bound) or higher than
+  // `v` (upper_bound), in precedence order. Only one block is decoded.
+  size_t lower_bound(const version& v) const noexcept;
+  size_t upper_bound(const version& v) const noexcept;
+
+  std::vector<packed_version> decode() const;
+
+ private:
+  template <class predicate_type>
+  size_t partition_point(const predicate_type& is_before) const noexcept;
+
+  std::vector<uint8_t> bytes_;
+  std::vector<uint64_t> block_offsets_;
+  size_t size_ = 0;
+};
+
+}  // namespace version_weaver
+
+#endif  // VERSION_WEAVER_COMPRESSED_LIST_H
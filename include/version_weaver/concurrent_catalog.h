@@ -0,0 +1,122 @@
+#ifndef VERSION_WEAVER_CONCURRENT_CATALOG_H
+#define VERSION_WEAVER_CONCURRENT_CATALOG_H
+#include "version_weaver.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace version_weaver {
+
+// The sorted versions of a package, with their text. Immutable once
+// published.
+struct package_versions {
+  std::string name;
+  std::string text;
+  std::vector<version> versions;
+};
+
+// Maps package names to sorted version lists. Readers never block: pinning
+// gives them an immutable snapshot of the whole catalog. Writers build each
+// new list off to the side, then publish it with a single atomic store of a
+// new root. Replaced objects are reclaimed once every reader that could still
+// see them has unpinned (epoch-based reclamation), by the next publish or by
+// the release of the last snapshot that held them.
+//
+// Packages live in a persistent hash trie: interior nodes have FANOUT
+// children, and leaves hold up to LEAF_CAPACITY pointers to lists, which
+// carry their package name. A publish copies the nodes on the path to its
+// leaf: FANOUT pointers per level, of which there are log_FANOUT(n) or so,
+// and at most LEAF_CAPACITY entries. Package names are never copied.
+// Writers are serialized with a mutex, which readers never wait for.
+class concurrent_catalog {
+  struct reader_record;
+  struct trie_node;
+
+ public:
+  static constexpr size_t FANOUT = 64;
+  static constexpr size_t LEAF_CAPACITY = 32;
+
+  concurrent_catalog();
+  concurrent_catalog(const concurrent_catalog&) = delete;
+  concurrent_catalog& operator=(const concurrent_catalog&) = delete;
+  // No reader may be registered any more.
+  ~concurrent_catalog();
+
+  // Replaces the versions of `package` with a sorted copy of `versions`.
+  void publish(std::string_view package, std::span<const version> versions);
+  // Removes a package. Returns false if it was not in the catalog.
+  bool erase(std::string_view package);
+
+  // The number of replaced lists and nodes that are not reclaimed yet.
+  size_t retired_count() const;
+
+  // The lookups of a pinned reader. Every span stays valid, and unchanged,
+  // until the snapshot is destroyed.
+  class snapshot {
+   public:
+    // Lookups see the catalog as it was when the snapshot was pinned.
+    snapshot(const snapshot&) = delete;
+    snapshot& operator=(const snapshot&) = delete;
+    ~snapshot();
+
+    // The sorted versions of a package, empty if it is unknown.
+    std::span<const version> find(std::string_view package) const noexcept;
+
+   private:
+    friend class concurrent_catalog;
+    snapshot(const concurrent_catalog& catalog, reader_record& record) noexcept;
+
+    const concurrent_catalog& catalog_;
+    reader_record& record_;
+    uint64_t epoch_;
+    const trie_node* root_;
+  };
+
+  // A registered reader, typically one per thread. Registration is lock-free
+  // and records are reused once their reader is destroyed.
+  class reader {
+   public:
+    explicit reader(const concurrent_catalog& catalog);
+    reader(const reader&) = delete;
+    reader& operator=(const reader&) = delete;
+    ~reader();
+
+    // A reader pins at most one snapshot at a time.
+    snapshot pin() const noexcept { return snapshot(catalog_, record_); }
+
+   private:
+    const concurrent_catalog& catalog_;
+    reader_record& record_;
+  };
+
+ private:
+  // Unlinked from the catalog while the global epoch was `epoch`.
+  struct retired {
+    uint64_t epoch;
+    std::vector<const trie_node*> old_nodes;
+    const package_versions* old_list;
+  };
+
+  reader_record& acquire_record() const;
+  // Publishes `list` as the versions of `package`, or removes the package
+  // when it is null. Returns false if there was nothing to remove.
+  bool replace(std::string_view package, const package_versions* list);
+  // Frees what no pinned reader can see. Needs the writer mutex.
+  void reclaim() const;
+  // Reclaims unless a writer holds the mutex; that writer reclaims instead.
+  void try_reclaim() const noexcept;
+
+  std::atomic<const trie_node*> root_;
+  std::atomic<uint64_t> epoch_{1};
+  mutable std::atomic<reader_record*> readers_{nullptr};
+  mutable std::mutex writer_mutex_;
+  mutable std::vector<retired> retired_;
+  // The epoch of the newest retired item, or 0 when nothing is retired.
+  mutable std::atomic<uint64_t> newest_retired_{0};
+};
+
+}  // namespace version_weaver
+
+#endif  // VERSION_WEAVER_CONCURRENT_CATALOG_H
@@ -0,0 +1,655 @@
+#ifndef VERSION_WEAVER_RANGE_H
+#define VERSION_WEAVER_RANGE_H
+#include "version_weaver.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace version_weaver {
+
+enum comparator_op {
+  LESS,
+  LESS_EQUAL,
+  GREATER,
+  GREATER_EQUAL,
+  EQUAL,
+};
+
+// A single comparison such as ">=1.2.3-beta". Caret and tilde ranges, partial
+// versions and wildcards are desugared into comparators when a range is
+// parsed: "^1.2" becomes ">=1.2.0 <2.0.0-0".
+struct comparator {
+  comparator_op op = GREATER_EQUAL;
+  uint64_t major = 0;
+  uint64_t minor = 0;
+  uint64_t patch = 0;
+  std::optional<std::string_view> pre_release;
+
+  friend constexpr bool operator==(const comparator&,
+                                   const comparator&) = default;
+};
+
+enum range_error {
+  INVALID_OPERATOR,
+  INVALID_BOUND,
+};
+
+// npm's includePrerelease and loose options.
+struct range_options {
+  // Lets pre-releases satisfy a range like any other version, without a
+  // bound with a pre-release on the same major.minor.patch. The lower bounds
+  // of partial versions then include their pre-releases: "1.x" means
+  // ">=1.0.0-0 <2.0.0-0".
+  bool include_prerelease = false;
+  // Accepts leading zeroes in bounds ("01.2.3") and pre-releases without a
+  // hyphen ("1.2.3beta").
+  bool loose = false;
+};
+
+// Desugared upper bounds such as "<2.0.0-0" exclude every pre-release of the
+// bound.
+inline constexpr std::string_view LOWEST_PRE_RELEASE = "0";
+
+constexpr std::strong_ordering compare_component(std::string_view digits,
+                                                 uint64_t bound) noexcept {
+  auto value = component_value(digits);
+  if (!value.has_value()) {
+    return std::strong_ordering::greater;
+  }
+  return *value <=> bound;
+}
+
+// Precedence of `v` relative to the bound of `c`. Components too wide for 64
+// bits rank above every bound.
+constexpr std::strong_ordering compare(const version& v,
+                                       const comparator& c) noexcept {
+  if (auto cmp = compare_component(v.major, c.major); cmp != 0) return cmp;
+  if (auto cmp = compare_component(v.minor, c.minor); cmp != 0) return cmp;
+  if (auto cmp = compare_component(v.patch, c.patch); cmp != 0) return cmp;
+  return compare_pre_release(v.pre_release, c.pre_release);
+}
+
+// Whether `v` passes the comparison alone, without the pre-release rule of
+// ranges.
+constexpr bool test(const comparator& c, const version& v) noexcept {
+  auto cmp = compare(v, c);
+  switch (c.op) {
+    case LESS:
+      return cmp < 0;
+    case LESS_EQUAL:
+      return cmp <= 0;
+    case GREATER:
+      return cmp > 0;
+    case GREATER_EQUAL:
+      return cmp >= 0;
+    case EQUAL:
+      return cmp == 0;
+  }
+  return false;
+}
+
+constexpr bool same_release(const version& v, const comparator& c) noexcept {
+  return compare_component(v.major, c.major) == 0 &&
+         compare_component(v.minor, c.minor) == 0 &&
+         compare_component(v.patch, c.patch) == 0;
+}
+
+// Whether `v` satisfies a comparator set: it passes every comparator, and
+// if it is a pre-release, a comparator has a pre-release on the same
+// major.minor.patch, unless `include_prerelease` is set.
+constexpr bool test_set(std::span<const comparator> set, const version& v,
+                        bool include_prerelease = false) noexcept {
+  if (!std::ranges::all_of(set, [&v](const comparator& c) {
+        return version_weaver::test(c, v);
+      })) {
+    return false;
+  }
+  return !v.pre_release.has_value() || include_prerelease ||
+         std::ranges::any_of(set, [&v](const comparator& c) {
+           return c.pre_release.has_value() && same_release(v, c);
+         });
+}
+
+// A version as written in a range, where trailing components may be missing
+// or wildcards: "1", "1.2", "1.x", "*".
+struct partial_version {
+  uint64_t major = 0;
+  uint64_t minor = 0;
+  uint64_t patch = 0;
+  // Number of leading numeric components.
+  int parts = 0;
+  std::optional<std::string_view> pre_release;
+};
+
+constexpr bool is_wildcard(std::string_view component) noexcept {
+  return component == "x" || component == "X" || component == "*";
+}
+
+constexpr std::optional<partial_version> parse_partial(std::string_view text,
+                                                      bool loose = false) {
+  if (!text.empty() && text.front() == 'v') {
+    text.remove_prefix(1);
+  }
+  partial_version result;
+  size_t plus = text.find('+');
+  if (plus != std::string_view::npos) {
+    // Build metadata is ignored, but must still be well-formed.
+    std::string_view build = text.substr(plus + 1);
+    if (build.empty() || build.front() == '.' || build.back() == '.' ||
+        build.find("..") != std::string_view::npos ||
+        !std::ranges::all_of(build, [](char c) {
+          return is_digit(c) || (c >= 'a' && c <= 'z') ||
+                 (c >= 'A' && c <= 'Z') || c == '-' || c == '.';
+        })) {
+      return std::nullopt;
+    }
+    text = text.substr(0, plus);
+  }
+  size_t dash = text.find('-');
+  if (loose && dash == std::string_view::npos) {
+    // "1.2.3beta": the pre-release starts after the digits of the patch.
+    size_t minor_dot = text.find('.');
+    size_t patch_dot = minor_dot == std::string_view::npos
+                           ? std::string_view::npos
+                           : text.find('.', minor_dot + 1);
+    if (patch_dot != std::string_view::npos) {
+      size_t digits = patch_dot + 1;
+      while (digits < text.size() && is_digit(text[digits])) digits++;
+      if (digits > patch_dot + 1 && digits < text.size()) {
+        result.pre_release = text.substr(digits);
+        if (!valid_pre_release(*result.pre_release)) {
+          return std::nullopt;
+        }
+        text = text.substr(0, digits);
+      }
+    }
+  }
+  if (dash != std::string_view::npos) {
+    result.pre_release = text.substr(dash + 1);
+    if (!valid_pre_release(*result.pre_release)) {
+      return std::nullopt;
+    }
+    text = text.substr(0, dash);
+  }
+
+  uint64_t* components[] = {&result.major, &result.minor, &result.patch};
+  bool wildcard = false;
+  size_t count = 0;
+  while (true) {
+    size_t dot = text.find('.');
+    std::string_view component = text.substr(0, dot);
+    if (count == 3) {
+      return std::nullopt;
+    }
+    if (is_wildcard(component)) {
+      wildcard = true;
+    } else {
+      auto value = component_value(component);
+      if (!value.has_value() ||
+          (!loose && component.size() > 1 && component.front() == '0')) {
+        return std::nullopt;
+      }
+      if (!wildcard) {
+        *components[count] = *value;
+        result.parts++;
+      }
+    }
+    count++;
+    if (dot == std::string_view::npos) break;
+    text = text.substr(dot + 1);
+  }
+  if (result.pre_release.has_value() && result.parts != 3) {
+    return std::nullopt;
+  }
+  return result;
+}
+
+// Emits the comparators equivalent to `op` applied to `v`, following npm's
+// desugaring of x-ranges, caret and tilde ranges.
+template <typename Emit>
+constexpr std::expected<void, range_error> desugar(
+    std::string_view op, const partial_version& v, Emit& emit,
+    bool include_prerelease = false) {
+  bool overflow = false;
+  auto next = [&overflow](uint64_t value) {
+    overflow = overflow || value == UINT64_MAX;
+    return value + 1;
+  };
+  auto add = [&emit](comparator_op op, uint64_t major, uint64_t minor,
+                     uint64_t patch,
+                     std::optional<std::string_view> pre_release = {}) {
+    emit(comparator{op, major, minor, patch, pre_release});
+  };
+  // The lower bound of a partial version, which takes in its pre-releases
+  // under include_prerelease.
+  std::optional<std::string_view> partial_floor;
+  if (include_prerelease) {
+    partial_floor = LOWEST_PRE_RELEASE;
+  }
+  // The versions between M.0.0 and (M+1).0.0, or M.m.0 and M.(m+1).0.
+  auto add_line = [&](uint64_t major, uint64_t minor) {
+    if (v.parts == 1) {
+      add(GREATER_EQUAL, major, 0, 0, partial_floor);
+      add(LESS, next(major), 0, 0, LOWEST_PRE_RELEASE);
+    } else {
+      add(GREATER_EQUAL, major, minor, 0, partial_floor);
+      add(LESS, major, next(minor), 0, LOWEST_PRE_RELEASE);
+    }
+  };
+
+  if (op.empty() || op == "=") {
+    if (v.parts == 3) {
+      add(EQUAL, v.major, v.minor, v.patch, v.pre_release);
+    } else if (v.parts > 0) {
+      add_line(v.major, v.minor);
+    }
+  } else if (op == "<" || op == "<=" || op == ">" || op == ">=") {
+    comparator_op primitive = op == "<"    ? LESS
+                              : op == "<=" ? LESS_EQUAL
+                              : op == ">"  ? GREATER
+                                           : GREATER_EQUAL;
+    if (v.parts == 3) {
+      add(primitive, v.major, v.minor, v.patch, v.pre_release);
+    } else if (v.parts == 0) {
+      // "<*" and ">*" match nothing; "<=*" and ">=*" match everything.
+      if (primitive == LESS || primitive == GREATER) {
+        add(LESS, 0, 0, 0, LOWEST_PRE_RELEASE);
+      }
+    } else if (primitive == GREATER) {
+      // >1 means >=2.0.0, >1.2 means >=1.3.0.
+      if (v.parts == 1) {
+        add(GREATER_EQUAL, next(v.major), 0, 0, partial_floor);
+      } else {
+        add(GREATER_EQUAL, v.major, next(v.minor), 0, partial_floor);
+      }
+    } else if (primitive == GREATER_EQUAL) {
+      add(GREATER_EQUAL, v.major, v.minor, 0, partial_floor);
+    } else if (primitive == LESS) {
+      add(LESS, v.major, v.minor, 0, LOWEST_PRE_RELEASE);
+    } else if (v.parts == 1) {
+      // <=1 means <2.0.0-0, <=1.2 means <1.3.0-0.
+      add(LESS, next(v.major), 0, 0, LOWEST_PRE_RELEASE);
+    } else {
+      add(LESS, v.major, next(v.minor), 0, LOWEST_PRE_RELEASE);
+    }
+  } else if (op == "^") {
+    // Allows changes that do not modify the left-most non-zero component.
+    if (v.parts == 1) {
+      add_line(v.major, 0);
+    } else if (v.parts == 2) {
+      add(GREATER_EQUAL, v.major, v.minor, 0, partial_floor);
+      if (v.major == 0) {
+        add(LESS, 0, next(v.minor), 0, LOWEST_PRE_RELEASE);
+      } else {
+        add(LESS, next(v.major), 0, 0, LOWEST_PRE_RELEASE);
+      }
+    } else if (v.parts == 3) {
+      add(GREATER_EQUAL, v.major, v.minor, v.patch, v.pre_release);
+      if (v.major != 0) {
+        add(LESS, next(v.major), 0, 0, LOWEST_PRE_RELEASE);
+      } else if (v.minor != 0) {
+        add(LESS, 0, next(v.minor), 0, LOWEST_PRE_RELEASE);
+      } else {
+        add(LESS, 0, 0, next(v.patch), LOWEST_PRE_RELEASE);
+      }
+    }
+  } else if (op == "~" || op == "~>") {
+    // Allows patch-level changes, or minor-level ones when only the major is
+    // given. As in npm, the lower bound never takes in pre-releases.
+    if (v.parts == 1) {
+      add(GREATER_EQUAL, v.major, 0, 0);
+      add(LESS, next(v.major), 0, 0, LOWEST_PRE_RELEASE);
+    } else if (v.parts > 1) {
+      add(GREATER_EQUAL, v.major, v.minor, v.patch, v.pre_release);
+      add(LESS, v.major, next(v.minor), 0, LOWEST_PRE_RELEASE);
+    }
+  } else {
+    return std::unexpected(range_error::INVALID_OPERATOR);
+  }
+  if (overflow) {
+    return std::unexpected(range_error::INVALID_BOUND);
+  }
+  return {};
+}
+
+constexpr bool is_space(char c) noexcept {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Parses a range, calling `emit` with every comparator and `end_set` after
+// every comparator set. Pre-release bounds are views into `input`.
+template <typename Emit, typename EndSet>
+constexpr std::expected<void, range_error> parse_comparators(
+    std::string_view input, range_options options, Emit&& emit,
+    EndSet&& end_set) {
+  std::string_view remaining = input;
+  while (true) {
+    size_t separator = remaining.find("||");
+    std::string_view set = remaining.substr(0, separator);
+    size_t i = 0;
+    while (true) {
+      while (i < set.size() && is_space(set[i])) i++;
+      if (i == set.size()) break;
+      size_t op_start = i;
+      while (i < set.size() && std::string_view("<>=~^").find(set[i]) !=
+                                   std::string_view::npos) {
+        i++;
+      }
+      std::string_view op = set.substr(op_start, i - op_start);
+      while (i < set.size() && is_space(set[i])) i++;
+      size_t bound_start = i;
+      while (i < set.size() && !is_space(set[i])) i++;
+      auto bound = parse_partial(set.substr(bound_start, i - bound_start),
+                                 options.loose);
+      if (!bound.has_value()) {
+        return std::unexpected(range_error::INVALID_BOUND);
+      }
+      // "A - B", with a hyphen between spaces, means ">=A <=B", where partial
+      // bounds are desugared as by >= and <=.
+      size_t hyphen = i;
+      while (hyphen < set.size() && is_space(set[hyphen])) hyphen++;
+      bool is_hyphen_range = op.empty() && hyphen > i &&
+                             hyphen + 1 < set.size() && set[hyphen] == '-' &&
+                             is_space(set[hyphen + 1]);
+      if (is_hyphen_range) {
+        i = hyphen + 1;
+        while (i < set.size() && is_space(set[i])) i++;
+        size_t upper_start = i;
+        while (i < set.size() && !is_space(set[i])) i++;
+        auto upper = parse_partial(set.substr(upper_start, i - upper_start),
+                                   options.loose);
+        if (upper_start == i || !upper.has_value()) {
+          return std::unexpected(range_error::INVALID_BOUND);
+        }
+        auto lower_desugared =
+            desugar(">=", *bound, emit, options.include_prerelease);
+        auto upper_desugared =
+            desugar("<=", *upper, emit, options.include_prerelease);
+        if (!lower_desugared.has_value() || !upper_desugared.has_value()) {
+          return std::unexpected(range_error::INVALID_BOUND);
+        }
+        continue;
+      }
+      auto desugared = desugar(op, *bound, emit, options.include_prerelease);
+      if (!desugared.has_value()) {
+        return std::unexpected(desugared.error());
+      }
+    }
+    end_set();
+    if (separator == std::string_view::npos) break;
+    remaining = remaining.substr(separator + 2);
+  }
+  return {};
+}
+
+// An npm range: comparator sets separated by "||", each a whitespace-separated
+// list of comparators, e.g. ">=1.2.7 <1.3.0 || ^2.0.0". A version satisfies
+// the range when it passes every comparator of at least one set. As in npm, a
+// pre-release only satisfies a set that has a comparator with a pre-release on
+// the same major.minor.patch: ">1.2.3-alpha.3" accepts 1.2.3-alpha.7 but not
+// 3.4.5-alpha.9. range_options relax both rules.
+//
+// Every set is desugared once, when the range is parsed, into a canonical
+// form: lower bounds, then exact versions, then upper bounds, each ordered by
+// precedence and without duplicates. Spellings with the same meaning up to
+// that form compare equal: "1.x", "1.*" and "1", or with include_prerelease,
+// "1.x" and "^1.0.0-0".
+//
+// Copies share the range text, which the pre-release bounds point into. The
+// text and comparators come from the memory resource given to parse_range();
+// copies allocate their comparators from the default resource, as pmr
+// containers do.
+class range {
+ public:
+  range() = default;
+
+  // Number of comparator sets.
+  size_t size() const noexcept { return set_ends_.size(); }
+  std::span<const comparator> set(size_t index) const noexcept {
+    size_t begin = index == 0 ? 0 : set_ends_[index - 1];
+    return std::span(comparators_).subspan(begin, set_ends_[index] - begin);
+  }
+  std::string_view text() const noexcept { return *text_; }
+  range_options options() const noexcept { return options_; }
+  // The canonical comparators, written as in npm: ">=1.0.0 <2.0.0-0 || 3.0.0".
+  // A set without comparators is written "*".
+  std::string canonical() const;
+  std::pmr::string canonical(std::pmr::memory_resource* resource) const;
+
+  bool test(const version& v) const noexcept;
+
+  // Whether the canonical forms and include_prerelease are the same.
+  bool operator==(const range& other) const noexcept {
+    return options_.include_prerelease == other.options_.include_prerelease &&
+           set_ends_ == other.set_ends_ && comparators_ == other.comparators_;
+  }
+
+ private:
+  friend std::expected<range, range_error> parse_range(
+      std::string_view input, range_options options,
+      std::pmr::memory_resource* resource);
+  friend class compiled_range;
+
+  explicit range(std::pmr::memory_resource* resource)
+      : comparators_(resource), set_ends_(resource) {}
+
+  std::shared_ptr<const std::pmr::string> text_;
+  range_options options_;
+  std::pmr::vector<comparator> comparators_;
+  std::pmr::vector<size_t> set_ends_;
+};
+
+std::expected<range, range_error> parse_range(
+    std::string_view input, range_options options = {},
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// Whether `version` satisfies `range`, read with `options`.
+bool satisfies(std::string_view version, std::string_view range,
+               range_options options);
+
+// A range compiled for testing many versions. Every comparator set becomes a
+// header followed by one instruction per comparator, holding the bound as a
+// packed integer key and the operator as a mask of passing orderings. The
+// components of a version are decoded at most once per test, rather than
+// once per comparator, and only as far as the comparisons need. Sets are
+// tried in order until one passes, and a set is skipped from its header alone
+// when the major of the version is outside the majors the set allows, or when
+// the version is a pre-release and the set cannot accept one. The
+// include_prerelease option of the range is resolved into the headers.
+// Components of 2^21 and above do not fit in the keys; ranges and versions
+// that have them are tested by range::test().
+class compiled_range {
+ public:
+  explicit compiled_range(range source);
+
+  const range& source() const noexcept { return source_; }
+  bool test(const version& v) const noexcept;
+
+ private:
+  struct instruction {
+    // The packed bound, or for a header, the lowest and highest majors the
+    // set allows in the high and low halves.
+    uint64_t key;
+    // The index of the comparator in the source range, or for a header, the
+    // number of comparators that follow.
+    uint32_t operand;
+    // The orderings of a version relative to the bound that pass: bit 0 for
+    // less, 1 for equal, 2 for greater. For a header, 1 when a pre-release
+    // needs a bound with a pre-release on its major.minor.patch.
+    uint8_t accept;
+    // Whether the bound has a pre-release, or for a header, whether
+    // pre-releases can satisfy the set at all.
+    bool pre_release;
+  };
+
+  range source_;
+  // Allocated from the resource of the source range.
+  std::pmr::vector<instruction> code_;
+  // False when a bound does not fit in a packed key.
+  bool packed_ = true;
+};
+
+// Parses and compiles ranges for repeated use. Each spelling is parsed once,
+// and spellings with the same canonical form share one compiled range, so
+// that "1.x", "1.*" and "1" are compiled once. Everything is allocated from
+// `resource`. Not thread-safe.
+class range_cache {
+ public:
+  explicit range_cache(
+      range_options options = {},
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : options_(options),
+        resource_(resource),
+        spellings_(resource),
+        compiled_(resource) {}
+
+  // The compiled range for `text`, valid as long as the cache.
+  std::expected<const compiled_range*, range_error> get(std::string_view text);
+
+  // Number of distinct spellings, and of distinct canonical forms.
+  size_t spelling_count() const noexcept { return spellings_.size(); }
+  size_t size() const noexcept { return compiled_.size(); }
+
+ private:
+  range_options options_;
+  std::pmr::memory_resource* resource_;
+  std::pmr::map<std::pmr::string, const compiled_range*, std::less<>>
+      spellings_;
+  // Map nodes do not move, so the compiled ranges are stored in place.
+  std::pmr::map<std::pmr::string, compiled_range, std::less<>> compiled_;
+};
+
+// Writes a shortest equivalent spelling of `r` to `output`, replacing its
+// contents, and returns a view of it. Each set keeps its tightest bounds,
+// empty sets are dropped, and overlapping or adjacent sets are merged when
+// that cannot change which pre-releases pass, so that ">=1.2.0 <2.0.0 ||
+// >=1.5.0 <2.0.0" becomes "^1.2.0". The text of `r` is written when it is no
+// longer. Reusing `output` avoids allocating once it is large enough, and the
+// scratch space comes from the resource of a std::pmr::string.
+std::string_view simplify(const range& r, std::string& output);
+std::string_view simplify(const range& r, std::pmr::string& output);
+
+// As npm's simplifyRange(): the runs of consecutive versions of `universe`,
+// sorted by precedence, that satisfy `r`, written as "*", "<=B", ">=A",
+// "A - B" or a version. The result matches `r` on `universe` only; when it
+// cannot (a run with pre-releases that the shorter spelling would exclude),
+// or is no shorter, simplify(r, output) is written instead.
+std::string_view simplify(const range& r, std::span<const version> universe,
+                          std::string& output);
+std::string_view simplify(const range& r, std::span<const version> universe,
+                          std::pmr::string& output);
+
+// The highest or lowest of `versions`, in any order, that satisfies `r`, or
+// std::nullopt. One pass keeps the best version so far and tests the range
+// only on versions that would replace it. Majors are decoded a chunk at a
+// time, and a chunk with no major beyond the best one is skipped whole. Of
+// versions of equal precedence, the first is returned.
+std::optional<version> max_satisfying(std::span<const version> versions,
+                                      const compiled_range& r);
+std::optional<version> max_satisfying(std::span<const version> versions,
+                                      const range& r);
+std::optional<version> min_satisfying(std::span<const version> versions,
+                                      const compiled_range& r);
+std::optional<version> min_satisfying(std::span<const version> versions,
+                                      const range& r);
+
+// A string literal usable as a template argument.
+template <size_t N>
+struct fixed_string {
+  char data[N]{};
+
+  constexpr fixed_string(const char (&text)[N]) noexcept {
+    std::copy_n(text, N, data);
+  }
+  constexpr std::string_view view() const noexcept { return {data, N - 1}; }
+};
+
+// A range parsed at compile time, such as static_range<">=18.0.0 <23.0.0">.
+// Its comparators are constants, so test() compiles down to a few integer
+// comparisons, without parsing or allocating. An invalid range does not
+// compile.
+template <fixed_string Text>
+class static_range {
+  struct counts {
+    size_t comparators = 0;
+    size_t sets = 0;
+    bool valid = false;
+  };
+  static constexpr counts count() {
+    counts result;
+    result.valid =
+        parse_comparators(
+            Text.view(), {},
+            [&result](const comparator&) { result.comparators++; },
+            [&result]() { result.sets++; })
+            .has_value();
+    return result;
+  }
+  static constexpr counts COUNTS = count();
+  static_assert(COUNTS.valid, "invalid range");
+
+  struct tables {
+    std::array<comparator, COUNTS.comparators> comparators;
+    std::array<size_t, COUNTS.sets> set_ends;
+  };
+  static constexpr tables build() {
+    tables result;
+    size_t comparators = 0;
+    size_t sets = 0;
+    (void)parse_comparators(
+        Text.view(), {},
+        [&](const comparator& c) { result.comparators[comparators++] = c; },
+        [&]() { result.set_ends[sets++] = comparators; });
+    return result;
+  }
+  static constexpr tables TABLES = build();
+
+ public:
+  static constexpr std::string_view text() noexcept { return Text.view(); }
+
+  static constexpr bool test(const version& v) noexcept {
+    size_t begin = 0;
+    for (size_t end : TABLES.set_ends) {
+      if (test_set(std::span(TABLES.comparators).subspan(begin, end - begin),
+                   v)) {
+        return true;
+      }
+      begin = end;
+    }
+    return false;
+  }
+};
+
+// A range and the version it resolved to, as recorded in a lockfile.
+struct locked_pair {
+  std::string_view range;
+  std::string_view version;
+};
+
+enum verify_error {
+  INVALID_LOCKED_RANGE,
+  INVALID_LOCKED_VERSION,
+  UNSATISFIED,
+};
+
+struct verify_failure {
+  size_t index;
+  verify_error error;
+};
+
+// Batches shorter than this are verified on a single thread.
+constexpr size_t PARALLEL_VERIFY_THRESHOLD = 1 << 13;
+
+// Checks that every version still satisfies its range, and returns the pairs
+// that fail, in index order. Identical range strings are parsed once, however
+// many pairs share them. Batches longer than PARALLEL_VERIFY_THRESHOLD are
+// split into chunks checked on up to `threads` threads.
+std::vector<verify_failure> verify_lockfile(std::span<const locked_pair> pairs,
+                                            size_t threads = 1);
+
+}  // namespace version_weaver
+
+#endif  // VERSION_WEAVER_RANGE_H
@@ -0,0 +1,106 @@
+#ifndef VERSION_WEAVER_RESOLVER_H
+#define VERSION_WEAVER_RESOLVER_H
+#include "version_weaver.h"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace version_weaver {
+
+enum resolve_error {
+  REGISTRY_IO_ERROR,
+  INVALID_REGISTRY,
+  INVALID_MANIFEST_RANGE,
+  UNRESOLVABLE,
+};
+
+// A dependency on any version of `name` satisfying `range`.
+struct dependency {
+  std::string_view name;
+  std::string_view range;
+};
+
+struct registry_version {
+  version release;
+  std::vector<dependency> dependencies;
+};
+
+struct registry_package {
+  std::string_view name;
+  // Sorted by precedence, lowest first.
+  std::vector<registry_version> versions;
+};
+
+// A local stand-in for a package registry, loaded from a text file with one
+// published version per line and tab-separated fields:
+//
+//   name <TAB> version [<TAB> dependency <TAB> range]...
+//
+// Empty lines and lines starting with '#' are ignored.
+class registry {
+ public:
+  static std::expected<registry, resolve_error> load(const std::string& path);
+  static std::expected<registry, resolve_error> parse(std::string_view text);
+
+  size_t size() const noexcept { return packages_.size(); }
+  const registry_package* find(std::string_view name) const noexcept;
+
+ private:
+  std::shared_ptr<const std::string> text_;
+  std::vector<registry_package> packages_;
+  std::unordered_map<std::string_view, size_t> index_;
+};
+
+struct resolved_package {
+  std::string_view name;
+  version release;
+  // Indices into resolution::packages, one per dependency of the release.
+  std::vector<size_t> dependencies;
+};
+
+// Every (name, version) pair appears once. Names and versions are views into
+// the registry, which must outlive the resolution.
+struct resolution {
+  std::vector<resolved_package> packages;
+  // The package chosen for each manifest entry.
+  std::vector<size_t> roots;
+};
+
+struct resolve_options {
+  // The subtrees of the manifest entries are resolved on up to this many
+  // threads.
+  size_t threads = 1;
+};
+
+// Resolves a manifest against the registry. Each dependency reuses a version
+// of its package that is already part of the subtree when one satisfies its
+// range, and otherwise takes the highest satisfying version whose own
+// dependencies resolve, backtracking to lower versions on failure. The
+// subtrees of the manifest entries are resolved independently, then merged,
+// so the result does not depend on the number of threads. Parsed ranges and
+// the candidate list of every (package, range) pair are memoized across
+// subtrees. Within a subtree, a pair that failed is not searched again
+// unless versions chosen since could change the outcome. That is always the
+// case for versions that a dependency cycle leads back to, and such searches
+// can take time exponential in the length of the cycle.
+std::expected<resolution, resolve_error> resolve(
+    const registry& packages, std::span<const dependency> manifest,
+    resolve_options options = {});
+
+// Finds a package by name, returning nullptr if it does not exist. Called
+// from every resolving thread at once. Every dependency range of the packages
+// it returns must be valid.
+using package_lookup =
+    std::function<const registry_package*(std::string_view name)>;
+
+// As above, over packages from any other source, such as metadata fetched
+// ahead of time.
+std::expected<resolution, resolve_error> resolve(
+    const package_lookup& lookup, std::span<const dependency> manifest,
+    resolve_options options = {});
+
+}  // namespace version_weaver
+
+#endif  // VERSION_WEAVER_RESOLVER_H
@@ -0,0 +1,301 @@
+#include "version_weaver/async_resolver.h"
+#include "version_weaver/range.h"
+
+#include <unordered_set>
+
+namespace version_weaver {
+
+executor::executor(size_t threads) {
+  threads = std::max<size_t>(threads, 1);
+  threads_.reserve(threads);
+  for (size_t t = 0; t < threads; t++) {
+    threads_.emplace_back([this]() { run(); });
+  }
+}
+
+executor::~executor() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void executor::post(std::coroutine_handle<> coroutine) {
+  // Notifies under the lock: once the coroutine runs, the executor may be
+  // destroyed.
+  std::lock_guard lock(mutex_);
+  queue_.push_back(coroutine);
+  ready_.notify_one();
+}
+
+void executor::run() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    auto coroutine = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+    coroutine.resume();
+    lock.lock();
+  }
+}
+
+registry_source::registry_source(const registry& packages,
+                                 std::chrono::microseconds latency)
+    : registry_source(packages,
+                      [latency](std::string_view) { return latency; }) {}
+
+registry_source::registry_source(const registry& packages,
+                                 latency_function latency)
+    : packages_(packages),
+      latency_(std::move(latency)),
+      timer_([this]() { run(); }) {}
+
+registry_source::~registry_source() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_one();
+  timer_.join();
+}
+
+void registry_source::fetch(std::string_view package,
+                            std::function<void(const registry_package*)> done) {
+  auto deadline = std::chrono::steady_clock::now() + latency_(package);
+  // Notifies under the lock, as in executor::post().
+  std::lock_guard lock(mutex_);
+  pending_.try_emplace({deadline, fetches_++}, packages_.find(package),
+                       std::move(done));
+  max_in_flight_ = std::max(max_in_flight_, ++in_flight_);
+  changed_.notify_one();
+}
+
+size_t registry_source::fetch_count() const {
+  std::lock_guard lock(mutex_);
+  return fetches_;
+}
+
+size_t registry_source::max_in_flight() const {
+  std::lock_guard lock(mutex_);
+  return max_in_flight_;
+}
+
+void registry_source::run() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    if (pending_.empty()) {
+      if (stopping_) {
+        return;
+      }
+      changed_.wait(lock);
+      continue;
+    }
+    auto deadline = pending_.begin()->first.first;
+    if (!stopping_ && std::chrono::steady_clock::now() < deadline) {
+      changed_.wait_until(lock, deadline);
+      continue;
+    }
+    auto next = pending_.extract(pending_.begin());
+    in_flight_--;
+    lock.unlock();
+    next.mapped().done(next.mapped().package);
+    lock.lock();
+  }
+}
+
+// A coroutine that starts at once and frees itself when it finishes.
+struct detached {
+  struct promise_type {
+    detached get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+// The packages reachable from a manifest, fetched concurrently. Every
+// (package, range) pair is expanded once, by its own coroutine.
+class closure {
+ public:
+  closure(metadata_source& source, executor& pool)
+      : source_(source), pool_(pool) {}
+
+  // Awaiting expand_all() expands the manifest, and resumes the awaiting
+  // coroutine on the pool once every reachable package has been fetched.
+  auto expand_all(std::span<const dependency> manifest) noexcept {
+    struct awaiter {
+      closure& reachable;
+      std::span<const dependency> manifest;
+
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> coroutine) {
+        reachable.finished_ = coroutine;
+        // Holds the count above zero until every entry has been spawned.
+        reachable.outstanding_ = 1;
+        for (const dependency& d : manifest) {
+          reachable.spawn(d.name, d.range);
+        }
+        reachable.finish();
+      }
+      void await_resume() noexcept {}
+    };
+    return awaiter{*this, manifest};
+  }
+
+  // Only valid once expand_all() has completed.
+  const registry_package* find(std::string_view name) const {
+    auto entry = packages_.find(name);
+    return entry == packages_.end() ? nullptr : entry->second.package;
+  }
+
+ private:
+  struct package_state {
+    const registry_package* package = nullptr;
+    bool fetched = false;
+    std::vector<std::coroutine_handle<>> waiters;
+  };
+
+  // Awaiting get() suspends until the package has been fetched, starting the
+  // fetch if no other coroutine has.
+  auto get(std::string_view name) noexcept {
+    struct awaiter {
+      closure& reachable;
+      std::string_view name;
+      const registry_package* result = nullptr;
+
+      bool await_ready() noexcept {
+        std::lock_guard lock(reachable.mutex_);
+        auto entry = reachable.packages_.find(name);
+        if (entry != reachable.packages_.end() && entry->second.fetched) {
+          result = entry->second.package;
+          return true;
+        }
+        return false;
+      }
+      bool await_suspend(std::coroutine_handle<> coroutine) {
+        bool first;
+        {
+          std::lock_guard lock(reachable.mutex_);
+          auto [entry, inserted] = reachable.packages_.try_emplace(name);
+          if (entry->second.fetched) {
+            result = entry->second.package;
+            return false;
+          }
+          entry->second.waiters.push_back(coroutine);
+          first = inserted;
+        }
+        if (first) {
+          reachable.source_.fetch(
+              name, [&owner = reachable, package = name](
+                        const registry_package* found) {
+                owner.arrived(package, found);
+              });
+        }
+        return true;
+      }
+      const registry_package* await_resume() {
+        if (result == nullptr) {
+          std::lock_guard lock(reachable.mutex_);
+          result = reachable.packages_.find(name)->second.package;
+        }
+        return result;
+      }
+    };
+    return awaiter{*this, name};
+  }
+
+  void arrived(std::string_view name, const registry_package* package) {
+    std::vector<std::coroutine_handle<>> waiters;
+    {
+      std::lock_guard lock(mutex_);
+      auto& state = packages_.find(name)->second;
+      state.package = package;
+      state.fetched = true;
+      waiters.swap(state.waiters);
+    }
+    for (auto waiter : waiters) {
+      pool_.post(waiter);
+    }
+  }
+
+  void spawn(std::string_view name, std::string_view range_text) {
+    std::string key;
+    key.reserve(name.size() + 1 + range_text.size());
+    key.append(name);
+    key.push_back('\0');
+    key.append(range_text);
+    {
+      std::lock_guard lock(mutex_);
+      if (!expanded_.insert(std::move(key)).second) {
+        return;
+      }
+      outstanding_++;
+    }
+    expand(name, range_text);
+  }
+
+  detached expand(std::string_view name, std::string_view range_text) {
+    // Runs on the pool rather than in the coroutine that spawned it.
+    co_await pool_.schedule();
+    const registry_package* package = co_await get(name);
+    if (package != nullptr) {
+      auto parsed = parse_range(range_text);
+      for (const registry_version& v : package->versions) {
+        if (parsed->test(v.release)) {
+          for (const dependency& d : v.dependencies) {
+            spawn(d.name, d.range);
+          }
+        }
+      }
+    }
+    finish();
+  }
+
+  void finish() {
+    std::coroutine_handle<> finished;
+    {
+      std::lock_guard lock(mutex_);
+      if (--outstanding_ == 0) {
+        finished = finished_;
+      }
+    }
+    // The closure may be destroyed as soon as the awaiting coroutine resumes.
+    if (finished) {
+      pool_.post(finished);
+    }
+  }
+
+  metadata_source& source_;
+  executor& pool_;
+  std::mutex mutex_;
+  std::unordered_map<std::string_view, package_state> packages_;
+  std::unordered_set<std::string> expanded_;
+  size_t outstanding_ = 0;
+  std::coroutine_handle<> finished_;
+};
+
+task<std::expected<resolution, resolve_error>> resolve_async(
+    metadata_source& source, executor& pool,
+    std::span<const dependency> manifest) {
+  for (const dependency& d : manifest) {
+    if (!parse_range(d.range).has_value()) {
+      co_return std::unexpected(INVALID_MANIFEST_RANGE);
+    }
+  }
+  closure reachable(source, pool);
+  co_await reachable.expand_all(manifest);
+  co_return resolve(
+      [&reachable](std::string_view name) { return reachable.find(name); },
+      manifest);
+}
+
+}  // namespace version_weaver
@@ -0,0 +1,448 @@
+#include "version_weaver/catalog.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace version_weaver {
+
+static constexpr char CATALOG_MAGIC[8] = {'V', 'W', 'C', 'A', 'T', 'L', 'O', 'G'};
+static constexpr uint32_t CATALOG_BYTE_ORDER = 0x01020304;
+
+static constexpr uint64_t align8(uint64_t offset) noexcept {
+  return (offset + 7) & ~uint64_t(7);
+}
+
+static uint64_t catalog_checksum(std::span<const std::byte> payload) {
+  return hash_finalize(hash_bytes(
+      std::string_view(reinterpret_cast<const char*>(payload.data()),
+                       payload.size()),
+      CATALOG_FORMAT_VERSION));
+}
+
+// The `length` bytes of `text` at `offset`, cut short where `text` ends.
+// Lookups go through it so that a catalog failing validate() is never read
+// out of bounds.
+static std::string_view slice(std::string_view text, uint64_t offset,
+                              uint64_t length) noexcept {
+  if (offset > text.size()) {
+    return {};
+  }
+  return text.substr(size_t(offset),
+                     size_t(std::min<uint64_t>(length, text.size() - offset)));
+}
+
+template <class T>
+static std::span<const T> slice(std::span<const T> items, uint64_t first,
+                                uint64_t count) noexcept {
+  if (first > items.size()) {
+    return {};
+  }
+  return items.subspan(size_t(first),
+                       size_t(std::min<uint64_t>(count, items.size() - first)));
+}
+
+version package_view::operator[](size_t index) const noexcept {
+  const catalog_record& record = records_[index];
+  std::string_view text = slice(heap_, record.text_offset, record.text_length);
+  version result;
+  uint64_t position = 0;
+  result.major = slice(text, position, record.major_length);
+  position += record.major_length + 1;
+  result.minor = slice(text, position, record.minor_length);
+  position += record.minor_length + 1;
+  result.patch = slice(text, position, record.patch_length);
+  position += record.patch_length + 1;
+  if (record.flags & CATALOG_RECORD_PRE_RELEASE) {
+    result.pre_release = slice(text, position, record.pre_release_length);
+    position += record.pre_release_length + 1;
+  }
+  if (record.flags & CATALOG_RECORD_BUILD) {
+    result.build = slice(text, position, text.size());
+  }
+  return result;
+}
+
+// Returns the section at `offset` holding `count` elements of type T, or an
+// empty optional when it does not fit in `bytes`.
+template <class T>
+static std::optional<std::span<const T>> catalog_section(
+    std::span<const std::byte> bytes, uint64_t offset, uint64_t count) {
+  if (offset % alignof(uint64_t) != 0 || offset > bytes.size() ||
+      count > (bytes.size() - offset) / sizeof(T)) {
+    return std::nullopt;
+  }
+  return std::span<const T>(reinterpret_cast<const T*>(bytes.data() + offset),
+                            size_t(count));
+}
+
+std::expected<catalog_view, catalog_error> catalog_view::open(
+    std::span<const std::byte> bytes) {
+  if (bytes.size() < sizeof(catalog_header)) {
+    return std::unexpected(CATALOG_TRUNCATED);
+  }
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(uint64_t) != 0) {
+    return std::unexpected(CATALOG_CORRUPT);
+  }
+  catalog_header header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (std::memcmp(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0) {
+    return std::unexpected(CATALOG_BAD_MAGIC);
+  }
+  if (header.format_version != CATALOG_FORMAT_VERSION ||
+      header.byte_order != CATALOG_BYTE_ORDER) {
+    return std::unexpected(CATALOG_UNSUPPORTED_FORMAT);
+  }
+  auto packages = catalog_section<catalog_package>(
+      bytes, header.directory_offset, header.package_count);
+  auto majors = catalog_section<uint64_t>(bytes, header.columns_offset,
+                                          header.version_count);
+  auto minors = catalog_section<uint64_t>(
+      bytes, header.columns_offset + 8 * header.version_count,
+      header.version_count);
+  auto patches = catalog_section<uint64_t>(
+      bytes, header.columns_offset + 16 * header.version_count,
+      header.version_count);
+  auto records = catalog_section<catalog_record>(bytes, header.records_offset,
+                                                 header.version_count);
+  auto heap = catalog_section<char>(bytes, header.heap_offset, header.heap_size);
+  if (!packages || !majors || !minors || !patches || !records || !heap) {
+    return std::unexpected(CATALOG_TRUNCATED);
+  }
+  catalog_view view;
+  view.bytes_ = bytes;
+  view.packages_ = *packages;
+  view.majors_ = *majors;
+  view.minors_ = *minors;
+  view.patches_ = *patches;
+  view.records_ = *records;
+  view.heap_ = std::string_view(heap->data(), heap->size());
+  return view;
+}
+
+std::expected<void, catalog_error> catalog_view::validate() const {
+  catalog_header header;
+  std::memcpy(&header, bytes_.data(), sizeof(header));
+  if (catalog_checksum(bytes_.subspan(sizeof(catalog_header))) !=
+      header.checksum) {
+    return std::unexpected(CATALOG_CHECKSUM_MISMATCH);
+  }
+  uint64_t next_version = 0;
+  for (size_t i = 0; i < packages_.size(); i++) {
+    const catalog_package& entry = packages_[i];
+    if (entry.name_offset > heap_.size() ||
+        entry.name_length > heap_.size() - entry.name_offset ||
+        entry.first_version != next_version ||
+        entry.version_count > records_.size() - next_version) {
+      return std::unexpected(CATALOG_CORRUPT);
+    }
+    next_version += entry.version_count;
+    if (i > 0 && !(package(i - 1).name() < package(i).name())) {
+      return std::unexpected(CATALOG_CORRUPT);
+    }
+  }
+  if (next_version != records_.size()) {
+    return std::unexpected(CATALOG_CORRUPT);
+  }
+  for (size_t p = 0; p < packages_.size(); p++) {
+    package_view versions = package(p);
+    for (size_t i = 0; i < versions.size(); i++) {
+      const catalog_record& record = versions.records()[i];
+      size_t expected_length = size_t(record.major_length) +
+                               record.minor_length + record.patch_length + 2;
+      if (record.flags & CATALOG_RECORD_PRE_RELEASE) {
+        expected_length += record.pre_release_length + 1;
+      }
+      if (record.text_offset > heap_.size() ||
+          record.text_length > heap_.size() - record.text_offset ||
+          expected_length > record.text_length ||
+          ((record.flags & CATALOG_RECORD_BUILD) == 0) !=
+              (expected_length == record.text_length)) {
+        return std::unexpected(CATALOG_CORRUPT);
+      }
+      version v = versions[i];
+      auto major = component_value(v.major);
+      auto minor = component_value(v.minor);
+      auto patch = component_value(v.patch);
+      bool wide = (record.flags & CATALOG_RECORD_WIDE) != 0;
+      if (major.value_or(UINT64_MAX) != versions.majors()[i] ||
+          minor.value_or(UINT64_MAX) != versions.minors()[i] ||
+          patch.value_or(UINT64_MAX) != versions.patches()[i] ||
+          wide == (major && minor && patch)) {
+        return std::unexpected(CATALOG_CORRUPT);
+      }
+      if (!parse(slice(heap_, record.text_offset, record.text_length))) {
+        return std::unexpected(CATALOG_CORRUPT);
+      }
+      if (i > 0 && versions[i] < versions[i - 1]) {
+        return std::unexpected(CATALOG_CORRUPT);
+      }
+    }
+  }
+  return {};
+}
+
+package_view catalog_view::package(size_t index) const noexcept {
+  const catalog_package& entry = packages_[index];
+  package_view view;
+  view.name_ = slice(heap_, entry.name_offset, entry.name_length);
+  view.majors_ = slice(majors_, entry.first_version, entry.version_count);
+  view.minors_ = slice(minors_, entry.first_version, entry.version_count);
+  view.patches_ = slice(patches_, entry.first_version, entry.version_count);
+  view.records_ = slice(records_, entry.first_version, entry.version_count);
+  view.heap_ = heap_;
+  return view;
+}
+
+std::optional<package_view> catalog_view::find(
+    std::string_view name) const noexcept {
+  size_t low = 0;
+  size_t high = packages_.size();
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    const catalog_package& entry = packages_[middle];
+    if (slice(heap_, entry.name_offset, entry.name_length) < name) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low == packages_.size()) {
+    return std::nullopt;
+  }
+  package_view view = package(low);
+  if (view.name() != name) {
+    return std::nullopt;
+  }
+  return view;
+}
+
+std::expected<void, catalog_error> catalog_writer::add(
+    std::string_view package, std::span<const std::string_view> versions) {
+  std::vector<std::string> canonical;
+  canonical.reserve(versions.size());
+  for (std::string_view v : versions) {
+    auto parsed = parse(v);
+    if (!parsed) {
+      return std::unexpected(CATALOG_INVALID_VERSION);
+    }
+    canonical.push_back(std::string(*parsed));
+  }
+  auto it = packages_.find(package);
+  if (it == packages_.end()) {
+    it = packages_.emplace(std::string(package), std::vector<std::string>{})
+             .first;
+  }
+  it->second.insert(it->second.end(),
+                    std::make_move_iterator(canonical.begin()),
+                    std::make_move_iterator(canonical.end()));
+  return {};
+}
+
+std::expected<void, catalog_error> catalog_writer::add(
+    std::string_view package, std::span<const version> versions) {
+  std::vector<std::string> text(versions.begin(), versions.end());
+  std::vector<std::string_view> views(text.begin(), text.end());
+  return add(package, views);
+}
+
+std::vector<std::byte> catalog_writer::finish() const {
+  uint64_t version_count = 0;
+  for (const auto& [name, versions] : packages_) {
+    version_count += versions.size();
+  }
+  catalog_header header{};
+  std::memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+  header.format_version = CATALOG_FORMAT_VERSION;
+  header.byte_order = CATALOG_BYTE_ORDER;
+  header.package_count = packages_.size();
+  header.version_count = version_count;
+  header.directory_offset = sizeof(catalog_header);
+  header.columns_offset =
+      header.directory_offset + packages_.size() * sizeof(catalog_package);
+  header.records_offset = header.columns_offset + 3 * 8 * version_count;
+  header.heap_offset =
+      header.records_offset + version_count * sizeof(catalog_record);
+
+  std::vector<catalog_package> directory;
+  directory.reserve(packages_.size());
+  std::vector<uint64_t> columns(3 * version_count);
+  std::vector<catalog_record> records;
+  records.reserve(version_count);
+  std::string heap;
+  for (const auto& [name, texts] : packages_) {
+    directory.push_back(
+        {heap.size(), name.size(), records.size(), texts.size()});
+    heap += name;
+    std::vector<version> versions;
+    versions.reserve(texts.size());
+    for (const auto& text : texts) {
+      versions.push_back(*parse(text));
+    }
+    sort_versions(versions);
+    for (const version& v : versions) {
+      auto major = component_value(v.major);
+      auto minor = component_value(v.minor);
+      auto patch = component_value(v.patch);
+      catalog_record record{};
+      record.text_offset = heap.size();
+      record.major_length = uint16_t(v.major.size());
+      record.minor_length = uint16_t(v.minor.size());
+      record.patch_length = uint16_t(v.patch.size());
+      if (v.pre_release) {
+        record.flags |= CATALOG_RECORD_PRE_RELEASE;
+        record.pre_release_length = uint16_t(v.pre_release->size());
+      }
+      if (v.build) {
+        record.flags |= CATALOG_RECORD_BUILD;
+      }
+      if (!major || !minor || !patch) {
+        record.flags |= CATALOG_RECORD_WIDE;
+      }
+      std::string text(v);
+      record.text_length = uint16_t(text.size());
+      heap += text;
+      columns[records.size()] = major.value_or(UINT64_MAX);
+      columns[version_count + records.size()] = minor.value_or(UINT64_MAX);
+      columns[2 * version_count + records.size()] = patch.value_or(UINT64_MAX);
+      records.push_back(record);
+    }
+  }
+  header.heap_size = heap.size();
+
+  std::vector<std::byte> bytes(align8(header.heap_offset + heap.size()));
+  std::memcpy(bytes.data() + header.directory_offset, directory.data(),
+              directory.size() * sizeof(catalog_package));
+  std::memcpy(bytes.data() + header.columns_offset, columns.data(),
+              columns.size() * sizeof(uint64_t));
+  std::memcpy(bytes.data() + header.records_offset, records.data(),
+              records.size() * sizeof(catalog_record));
+  std::memcpy(bytes.data() + header.heap_offset, heap.data(), heap.size());
+  header.checksum =
+      catalog_checksum(std::span(bytes).subspan(sizeof(catalog_header)));
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  return bytes;
+}
+
+std::expected<void, catalog_error> catalog_writer::write(
+    const std::string& path) const {
+  std::vector<std::byte> bytes = finish();
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(bytes.data()),
+            std::streamsize(bytes.size()));
+  out.close();
+  if (!out) {
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  return {};
+}
+
+std::expected<mapped_file, catalog_error> mapped_file::open(
+    const std::string& path) {
+  mapped_file file;
+#ifdef _WIN32
+  HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(handle, &size)) {
+    CloseHandle(handle);
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(handle);
+    return std::unexpected(CATALOG_TRUNCATED);
+  }
+  file.mapping_ =
+      CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(handle);
+  if (file.mapping_ == nullptr) {
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  file.data_ = MapViewOfFile(file.mapping_, FILE_MAP_READ, 0, 0, 0);
+  if (file.data_ == nullptr) {
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  file.size_ = size_t(size.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    ::close(fd);
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  if (status.st_size == 0) {
+    ::close(fd);
+    return std::unexpected(CATALOG_TRUNCATED);
+  }
+  void* data =
+      mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return std::unexpected(CATALOG_IO_ERROR);
+  }
+  file.data_ = data;
+  file.size_ = size_t(status.st_size);
+#endif
+  return file;
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+      ,
+      mapping_(std::exchange(other.mapping_, nullptr))
+#endif
+{
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+  // The previous mapping, if any, is released by `other`.
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+#ifdef _WIN32
+  std::swap(mapping_, other.mapping_);
+#endif
+  return *this;
+}
+
+mapped_file::~mapped_file() {
+#ifdef _WIN32
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+#else
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+#endif
+}
+
+}  // namespace version_weaver
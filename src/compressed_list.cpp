@@ -0,0 +1,231 @@
+#include "version_weaver/compressed_list.h"
+
+namespace version_weaver {
+
+enum entry_tag : uint8_t {
+  ENTRY_PRE_RELEASE = 1,
+  ENTRY_BUILD = 2,
+  // The remaining bits say which component changed first.
+  ENTRY_PATCH_CHANGED = 0 << 2,
+  ENTRY_MINOR_CHANGED = 1 << 2,
+  ENTRY_MAJOR_CHANGED = 2 << 2,
+  ENTRY_CHANGE_MASK = 3 << 2,
+};
+
+static void write_varint(std::vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(uint8_t(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(uint8_t(value));
+}
+
+static uint64_t read_varint(const uint8_t* data, size_t& offset) noexcept {
+  uint64_t value = 0;
+  int shift = 0;
+  while (data[offset] & 0x80) {
+    value |= uint64_t(data[offset++] & 0x7f) << shift;
+    shift += 7;
+  }
+  return value | (uint64_t(data[offset++]) << shift);
+}
+
+// Decodes the entry at `offset` on top of `current`, which holds the
+// previous entry (or zeroes at the start of a block).
+static void decode_entry(const uint8_t* data, size_t& offset,
+                         packed_version& current) noexcept {
+  uint8_t tag = data[offset++];
+  switch (tag & ENTRY_CHANGE_MASK) {
+    case ENTRY_MAJOR_CHANGED:
+      current.major += read_varint(data, offset);
+      current.minor = read_varint(data, offset);
+      current.patch = read_varint(data, offset);
+      break;
+    case ENTRY_MINOR_CHANGED:
+      current.minor += read_varint(data, offset);
+      current.patch = read_varint(data, offset);
+      break;
+    default:
+      current.patch += read_varint(data, offset);
+      break;
+  }
+  auto read_string = [data, &offset]() {
+    size_t length = size_t(read_varint(data, offset));
+    std::string_view text(reinterpret_cast<const char*>(data + offset), length);
+    offset += length;
+    return text;
+  };
+  current.pre_release.reset();
+  current.build.reset();
+  if (tag & ENTRY_PRE_RELEASE) {
+    current.pre_release = read_string();
+  }
+  if (tag & ENTRY_BUILD) {
+    current.build = read_string();
+  }
+}
+
+packed_version::operator std::string() const {
+  std::string result = std::to_string(major) + "." + std::to_string(minor) +
+                       "." + std::to_string(patch);
+  if (pre_release.has_value()) {
+    result += "-" + std::string(pre_release.value());
+  }
+  if (build.has_value()) {
+    result += "+" + std::string(build.value());
+  }
+  return result;
+}
+
+std::strong_ordering compare(const packed_version& first,
+                             const version& second) noexcept {
+  // A component too wide for 64 bits is larger than any packed one.
+  auto major = component_value(second.major);
+  if (!major || first.major != *major) {
+    return major ? first.major <=> *major : std::strong_ordering::less;
+  }
+  auto minor = component_value(second.minor);
+  if (!minor || first.minor != *minor) {
+    return minor ? first.minor <=> *minor : std::strong_ordering::less;
+  }
+  auto patch = component_value(second.patch);
+  if (!patch || first.patch != *patch) {
+    return patch ? first.patch <=> *patch : std::strong_ordering::less;
+  }
+  return compare_pre_release(first.pre_release, second.pre_release);
+}
+
+std::expected<compressed_version_list, parse_error>
+compressed_version_list::encode(std::span<const version> sorted) {
+  compressed_version_list list;
+  list.size_ = sorted.size();
+  list.block_offsets_.reserve((sorted.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+  uint64_t major = 0, minor = 0, patch = 0;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    const version& v = sorted[i];
+    auto next_major = component_value(v.major);
+    auto next_minor = component_value(v.minor);
+    auto next_patch = component_value(v.patch);
+    if (!next_major) {
+      return std::unexpected(parse_error::INVALID_MAJOR);
+    }
+    if (!next_minor) {
+      return std::unexpected(parse_error::INVALID_MINOR);
+    }
+    if (!next_patch) {
+      return std::unexpected(parse_error::INVALID_PATCH);
+    }
+    if (i > 0 && v < sorted[i - 1]) {
+      return std::unexpected(parse_error::INVALID_INPUT);
+    }
+    uint8_t tag = (v.pre_release ? ENTRY_PRE_RELEASE : 0) |
+                  (v.build ? ENTRY_BUILD : 0);
+    if (i % BLOCK_SIZE == 0) {
+      list.block_offsets_.push_back(list.bytes_.size());
+      major = minor = patch = 0;
+    }
+    if (*next_major != major || i % BLOCK_SIZE == 0) {
+      list.bytes_.push_back(tag | ENTRY_MAJOR_CHANGED);
+      write_varint(list.bytes_, *next_major - major);
+      write_varint(list.bytes_, *next_minor);
+      write_varint(list.bytes_, *next_patch);
+    } else if (*next_minor != minor) {
+      list.bytes_.push_back(tag | ENTRY_MINOR_CHANGED);
+      write_varint(list.bytes_, *next_minor - minor);
+      write_varint(list.bytes_, *next_patch);
+    } else {
+      list.bytes_.push_back(tag | ENTRY_PATCH_CHANGED);
+      write_varint(list.bytes_, *next_patch - patch);
+    }
+    for (auto text : {v.pre_release, v.build}) {
+      if (text.has_value()) {
+        write_varint(list.bytes_, text->size());
+        list.bytes_.insert(list.bytes_.end(), text->begin(), text->end());
+      }
+    }
+    major = *next_major;
+    minor = *next_minor;
+    patch = *next_patch;
+  }
+  list.bytes_.shrink_to_fit();
+  return list;
+}
+
+void compressed_version_list::cursor::next() noexcept {
+  index_++;
+  if (done()) {
+    return;
+  }
+  if (index_ % BLOCK_SIZE == 0) {
+    current_ = packed_version{};
+  }
+  decode_entry(list_->bytes_.data(), offset_, current_);
+}
+
+compressed_version_list::cursor compressed_version_list::at(
+    size_t index) const noexcept {
+  cursor c;
+  c.list_ = this;
+  c.index_ = index;
+  if (index >= size_) {
+    c.index_ = size_;
+    return c;
+  }
+  size_t first = index - index % BLOCK_SIZE;
+  c.offset_ = size_t(block_offsets_[first / BLOCK_SIZE]);
+  decode_entry(bytes_.data(), c.offset_, c.current_);
+  for (size_t i = first + 1; i <= index; i++) {
+    decode_entry(bytes_.data(), c.offset_, c.current_);
+  }
+  return c;
+}
+
+// Returns the first index whose entry is not `is_before`, assuming the
+// predicate holds for a prefix of the list.
+template <class predicate_type>
+size_t compressed_version_list::partition_point(
+    const predicate_type& is_before) const noexcept {
+  // Find the first block that starts at or after the partition point...
+  size_t low = 0;
+  size_t high = block_offsets_.size();
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (is_before(*at(middle * BLOCK_SIZE))) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low == 0) {
+    return 0;
+  }
+  // ...then scan the block before it.
+  size_t last = std::min(size_, low * BLOCK_SIZE);
+  for (cursor c = at((low - 1) * BLOCK_SIZE); c.index() < last; c.next()) {
+    if (!is_before(*c)) {
+      return c.index();
+    }
+  }
+  return last;
+}
+
+size_t compressed_version_list::lower_bound(const version& v) const noexcept {
+  return partition_point(
+      [&v](const packed_version& entry) { return compare(entry, v) < 0; });
+}
+
+size_t compressed_version_list::upper_bound(const version& v) const noexcept {
+  return partition_point(
+      [&v](const packed_version& entry) { return compare(entry, v) <= 0; });
+}
+
+std::vector<packed_version> compressed_version_list::decode() const {
+  std::vector<packed_version> result;
+  result.reserve(size_);
+  for (cursor c = begin(); !c.done(); c.next()) {
+    result.push_back(*c);
+  }
+  return result;
+}
+
+}  // namespace version_weaver
@@ -0,0 +1,296 @@
+#include "version_weaver/concurrent_catalog.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace version_weaver {
+
+// The epoch a reader pinned, or 0 while it is not reading. Each record has
+// its own cache line, so that pinning never contends with other readers.
+struct alignas(64) concurrent_catalog::reader_record {
+  std::atomic<uint64_t> epoch{0};
+  std::atomic<bool> in_use{true};
+  reader_record* next = nullptr;
+};
+
+// A node of the hash trie. Interior nodes have FANOUT children, indexed by
+// the next bits of the package hash, and null where no package is. Leaves
+// have no children, and hold their lists sorted by hash.
+struct concurrent_catalog::trie_node {
+  struct entry {
+    uint64_t hash;
+    const package_versions* list;
+  };
+  std::vector<const trie_node*> children;
+  std::vector<entry> entries;
+};
+
+static constexpr size_t NODE_BITS = std::countr_zero(
+    concurrent_catalog::FANOUT);
+static_assert(size_t(1) << NODE_BITS == concurrent_catalog::FANOUT);
+
+static uint64_t package_hash(std::string_view package) noexcept {
+  return hash_finalize(hash_bytes(package, 0));
+}
+
+concurrent_catalog::concurrent_catalog() : root_(new trie_node()) {}
+
+concurrent_catalog::~concurrent_catalog() {
+  std::vector<const trie_node*> nodes = {root_.load(std::memory_order_relaxed)};
+  while (!nodes.empty()) {
+    const trie_node* node = nodes.back();
+    nodes.pop_back();
+    for (const trie_node* child : node->children) {
+      if (child != nullptr) {
+        nodes.push_back(child);
+      }
+    }
+    for (const auto& item : node->entries) {
+      delete item.list;
+    }
+    delete node;
+  }
+  for (const auto& item : retired_) {
+    for (const trie_node* node : item.old_nodes) {
+      delete node;
+    }
+    delete item.old_list;
+  }
+  auto* record = readers_.load(std::memory_order_relaxed);
+  while (record != nullptr) {
+    auto* next = record->next;
+    delete record;
+    record = next;
+  }
+}
+
+void concurrent_catalog::publish(std::string_view package,
+                                 std::span<const version> versions) {
+  // The list is built before taking the writer lock, and never changes once
+  // it is published.
+  auto* list = new package_versions();
+  list->name = package;
+  size_t bytes = 0;
+  for (const auto& v : versions) {
+    bytes += v.major.size() + v.minor.size() + v.patch.size() +
+             v.pre_release.value_or("").size() + v.build.value_or("").size();
+  }
+  // Reserving up front keeps the views stable while the text is appended.
+  list->text.reserve(bytes);
+  auto copy = [list](std::string_view part) {
+    size_t offset = list->text.size();
+    list->text.append(part);
+    return std::string_view(list->text.data() + offset, part.size());
+  };
+  auto copy_optional = [&copy](std::optional<std::string_view> part) {
+    return part ? std::optional(copy(*part)) : std::nullopt;
+  };
+  list->versions.reserve(versions.size());
+  for (const auto& v : versions) {
+    list->versions.push_back({copy(v.major), copy(v.minor), copy(v.patch),
+                              copy_optional(v.pre_release),
+                              copy_optional(v.build)});
+  }
+  sort_versions(list->versions);
+  replace(package, list);
+}
+
+bool concurrent_catalog::erase(std::string_view package) {
+  return replace(package, nullptr);
+}
+
+bool concurrent_catalog::replace(std::string_view package,
+                                 const package_versions* list) {
+  using entry = trie_node::entry;
+  std::lock_guard lock(writer_mutex_);
+  const trie_node* old_root = root_.load(std::memory_order_relaxed);
+  uint64_t hash = package_hash(package);
+  // The interior nodes down to the leaf of `package`, which is null when no
+  // package has its hash prefix yet.
+  std::vector<const trie_node*> path;
+  const trie_node* leaf = old_root;
+  size_t shift = 0;
+  while (leaf != nullptr && !leaf->children.empty()) {
+    path.push_back(leaf);
+    leaf = leaf->children[(hash >> shift) % FANOUT];
+    shift += NODE_BITS;
+  }
+
+  std::vector<entry> entries;
+  if (leaf != nullptr) {
+    entries = leaf->entries;
+  }
+  auto position = std::ranges::lower_bound(entries, hash, {}, &entry::hash);
+  while (position != entries.end() && position->hash == hash &&
+         position->list->name != package) {
+    ++position;
+  }
+  const package_versions* old_list = nullptr;
+  if (position != entries.end() && position->hash == hash) {
+    old_list = position->list;
+    if (list != nullptr) {
+      position->list = list;
+    } else {
+      entries.erase(position);
+    }
+  } else if (list != nullptr) {
+    entries.insert(position, {hash, list});
+  } else {
+    return false;
+  }
+
+  // A leaf that outgrows its capacity becomes an interior node, as long as
+  // there are hash bits left to tell its entries apart.
+  auto build = [](auto& self, std::span<const entry> sorted,
+                  size_t bits) -> const trie_node* {
+    auto* node = new trie_node();
+    if (sorted.size() <= LEAF_CAPACITY || bits >= 64) {
+      node->entries.assign(sorted.begin(), sorted.end());
+      return node;
+    }
+    node->children.resize(FANOUT);
+    std::vector<std::vector<entry>> parts(FANOUT);
+    for (const entry& item : sorted) {
+      parts[(item.hash >> bits) % FANOUT].push_back(item);
+    }
+    for (size_t i = 0; i < FANOUT; i++) {
+      if (!parts[i].empty()) {
+        node->children[i] = self(self, parts[i], bits + NODE_BITS);
+      }
+    }
+    return node;
+  };
+  const trie_node* replacement = nullptr;
+  if (!entries.empty() || path.empty()) {
+    replacement = build(build, entries, shift);
+  }
+  // Copy the path above the leaf, bottom up.
+  for (size_t level = path.size(); level-- > 0;) {
+    shift -= NODE_BITS;
+    auto* copy = new trie_node(*path[level]);
+    copy->children[(hash >> shift) % FANOUT] = replacement;
+    replacement = copy;
+  }
+  root_.store(replacement, std::memory_order_seq_cst);
+  // Readers that pin from now on see the new root; the ones pinned at the
+  // current epoch or before may still hold the old one.
+  uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+  if (leaf != nullptr) {
+    path.push_back(leaf);
+  }
+  retired_.push_back({epoch, std::move(path), old_list});
+  newest_retired_.store(epoch, std::memory_order_relaxed);
+  reclaim();
+  return true;
+}
+
+size_t concurrent_catalog::retired_count() const {
+  std::lock_guard lock(writer_mutex_);
+  size_t count = 0;
+  for (const auto& item : retired_) {
+    count += item.old_nodes.size() + (item.old_list != nullptr);
+  }
+  return count;
+}
+
+void concurrent_catalog::reclaim() const {
+  uint64_t oldest = UINT64_MAX;
+  for (auto* record = readers_.load(std::memory_order_acquire);
+       record != nullptr; record = record->next) {
+    uint64_t epoch = record->epoch.load(std::memory_order_seq_cst);
+    if (epoch != 0) {
+      oldest = std::min(oldest, epoch);
+    }
+  }
+  std::erase_if(retired_, [oldest](const retired& item) {
+    if (item.epoch >= oldest) {
+      return false;
+    }
+    for (const trie_node* node : item.old_nodes) {
+      delete node;
+    }
+    delete item.old_list;
+    return true;
+  });
+  if (retired_.empty()) {
+    newest_retired_.store(0, std::memory_order_relaxed);
+  }
+}
+
+void concurrent_catalog::try_reclaim() const noexcept {
+  std::unique_lock lock(writer_mutex_, std::try_to_lock);
+  if (lock.owns_lock()) {
+    reclaim();
+  }
+}
+
+concurrent_catalog::reader_record& concurrent_catalog::acquire_record() const {
+  for (auto* record = readers_.load(std::memory_order_acquire);
+       record != nullptr; record = record->next) {
+    bool free = false;
+    if (record->in_use.compare_exchange_strong(free, true,
+                                               std::memory_order_acquire)) {
+      return *record;
+    }
+  }
+  auto* record = new reader_record();
+  record->next = readers_.load(std::memory_order_relaxed);
+  while (!readers_.compare_exchange_weak(record->next, record,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+  }
+  return *record;
+}
+
+concurrent_catalog::reader::reader(const concurrent_catalog& catalog)
+    : catalog_(catalog), record_(catalog.acquire_record()) {}
+
+concurrent_catalog::reader::~reader() {
+  record_.epoch.store(0, std::memory_order_release);
+  record_.in_use.store(false, std::memory_order_release);
+  if (catalog_.newest_retired_.load(std::memory_order_relaxed) != 0) {
+    catalog_.try_reclaim();
+  }
+}
+
+concurrent_catalog::snapshot::snapshot(const concurrent_catalog& catalog,
+                                       reader_record& record) noexcept
+    : catalog_(catalog),
+      record_(record),
+      epoch_(catalog.epoch_.load(std::memory_order_seq_cst)) {
+  // Sequentially consistent, so that a writer scanning the records either
+  // sees this pin or published its new root before we load it.
+  record_.epoch.store(epoch_, std::memory_order_seq_cst);
+  root_ = catalog.root_.load(std::memory_order_seq_cst);
+}
+
+concurrent_catalog::snapshot::~snapshot() {
+  record_.epoch.store(0, std::memory_order_release);
+  // Items retired at our epoch or later may have waited for this snapshot.
+  if (catalog_.newest_retired_.load(std::memory_order_relaxed) >= epoch_) {
+    catalog_.try_reclaim();
+  }
+}
+
+std::span<const version> concurrent_catalog::snapshot::find(
+    std::string_view package) const noexcept {
+  uint64_t hash = package_hash(package);
+  const trie_node* node = root_;
+  for (size_t shift = 0; node != nullptr && !node->children.empty();
+       shift += NODE_BITS) {
+    node = node->children[(hash >> shift) % FANOUT];
+  }
+  if (node == nullptr) {
+    return {};
+  }
+  auto entry = std::ranges::lower_bound(node->entries, hash, {},
+                                        &trie_node::entry::hash);
+  for (; entry != node->entries.end() && entry->hash == hash; ++entry) {
+    if (entry->list->name == package) {
+      return entry->list->versions;
+    }
+  }
+  return {};
+}
+
+}  // namespace version_weaver
@@ -0,0 +1,837 @@
+#include "version_weaver/range.h"
+
+#include <charconv>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+
+namespace version_weaver {
+
+bool range::test(const version& v) const noexcept {
+  for (size_t i = 0; i < size(); i++) {
+    if (test_set(set(i), v, options_.include_prerelease)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Precedence of the bound of `a` relative to the bound of `b`.
+static std::strong_ordering compare_bounds(const comparator& a,
+                                           const comparator& b) noexcept {
+  if (auto cmp = a.major <=> b.major; cmp != 0) return cmp;
+  if (auto cmp = a.minor <=> b.minor; cmp != 0) return cmp;
+  if (auto cmp = a.patch <=> b.patch; cmp != 0) return cmp;
+  return compare_pre_release(a.pre_release, b.pre_release);
+}
+
+// The canonical order within a set: lower bounds, exact versions, then upper
+// bounds, each by precedence.
+static bool canonical_less(const comparator& a, const comparator& b) noexcept {
+  auto rank = [](comparator_op op) {
+    return op == GREATER || op == GREATER_EQUAL ? 0 : op == EQUAL ? 1 : 2;
+  };
+  if (rank(a.op) != rank(b.op)) return rank(a.op) < rank(b.op);
+  if (auto cmp = compare_bounds(a, b); cmp != 0) return cmp < 0;
+  return a.op < b.op;
+}
+
+// Writes a number without a temporary string.
+template <typename String>
+void append_number(String& out, uint64_t value) {
+  char digits[20];
+  auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+  out.append(digits, end);
+}
+
+// Writes a bound as major.minor.patch[-pre-release].
+template <typename String>
+void append_bound(String& out, const comparator& c) {
+  append_number(out, c.major);
+  out += '.';
+  append_number(out, c.minor);
+  out += '.';
+  append_number(out, c.patch);
+  if (c.pre_release.has_value()) {
+    out += '-';
+    out += *c.pre_release;
+  }
+}
+
+template <typename String>
+void append_canonical(String& out, const range& r) {
+  static constexpr std::string_view ops[] = {"<", "<=", ">", ">=", ""};
+  for (size_t i = 0; i < r.size(); i++) {
+    if (i > 0) {
+      out += " || ";
+    }
+    auto comparators = r.set(i);
+    if (comparators.empty()) {
+      out += '*';
+    }
+    for (size_t j = 0; j < comparators.size(); j++) {
+      if (j > 0) {
+        out += ' ';
+      }
+      out += ops[comparators[j].op];
+      append_bound(out, comparators[j]);
+    }
+  }
+}
+
+std::string range::canonical() const {
+  std::string result;
+  append_canonical(result, *this);
+  return result;
+}
+
+std::pmr::string range::canonical(std::pmr::memory_resource* resource) const {
+  std::pmr::string result(resource);
+  append_canonical(result, *this);
+  return result;
+}
+
+std::expected<range, range_error> parse_range(
+    std::string_view input, range_options options,
+    std::pmr::memory_resource* resource) {
+  range result(resource);
+  auto text = std::allocate_shared<const std::pmr::string>(
+      std::pmr::polymorphic_allocator<>(resource), input);
+  auto end_set = [&comparators = result.comparators_,
+                  &set_ends = result.set_ends_]() {
+    auto begin = comparators.begin() + (set_ends.empty() ? 0 : set_ends.back());
+    std::sort(begin, comparators.end(), canonical_less);
+    comparators.erase(std::unique(begin, comparators.end()),
+                      comparators.end());
+    set_ends.push_back(comparators.size());
+  };
+  auto parsed = parse_comparators(
+      *text, options,
+      [&result](const comparator& c) { result.comparators_.push_back(c); },
+      end_set);
+  if (!parsed.has_value()) {
+    return std::unexpected(parsed.error());
+  }
+  result.text_ = std::move(text);
+  result.options_ = options;
+  return result;
+}
+
+constexpr int PACKED_COMPONENT_BITS = 21;
+constexpr uint64_t PACKED_COMPONENT_LIMIT = uint64_t{1}
+                                           << PACKED_COMPONENT_BITS;
+// The shifts of major, minor and patch in a packed key.
+constexpr int PACKED_SHIFTS[] = {2 * PACKED_COMPONENT_BITS + 1,
+                                 PACKED_COMPONENT_BITS + 1, 1};
+
+// Packs major, minor and patch into a key ordered by precedence, with a low
+// bit set for releases, which rank above the pre-releases of the same
+// major.minor.patch. Pre-releases of the same major.minor.patch share a key.
+static std::optional<uint64_t> pack_key(uint64_t major, uint64_t minor,
+                                        uint64_t patch,
+                                        bool pre_release) noexcept {
+  if (major >= PACKED_COMPONENT_LIMIT || minor >= PACKED_COMPONENT_LIMIT ||
+      patch >= PACKED_COMPONENT_LIMIT) {
+    return std::nullopt;
+  }
+  return major << PACKED_SHIFTS[0] | minor << PACKED_SHIFTS[1] |
+         patch << PACKED_SHIFTS[2] | !pre_release;
+}
+
+// The orderings passing `op`: bit 0 for less, 1 for equal, 2 for greater.
+static constexpr uint8_t accepted_orderings(comparator_op op) noexcept {
+  switch (op) {
+    case LESS:
+      return 0b001;
+    case LESS_EQUAL:
+      return 0b011;
+    case GREATER:
+      return 0b100;
+    case GREATER_EQUAL:
+      return 0b110;
+    case EQUAL:
+      return 0b010;
+  }
+  return 0;
+}
+
+compiled_range::compiled_range(range source)
+    : source_(std::move(source)),
+      code_(source_.comparators_.get_allocator()) {
+  uint32_t index = 0;
+  for (size_t i = 0; i < source_.size(); i++) {
+    auto set = source_.set(i);
+    size_t header = code_.size();
+    bool include_prerelease = source_.options().include_prerelease;
+    code_.push_back({0, static_cast<uint32_t>(set.size()),
+                     !include_prerelease, include_prerelease});
+    uint64_t lowest_major = 0;
+    uint64_t highest_major = PACKED_COMPONENT_LIMIT - 1;
+    for (const comparator& c : set) {
+      auto key = pack_key(c.major, c.minor, c.patch, c.pre_release.has_value());
+      if (!key.has_value()) {
+        packed_ = false;
+        code_.clear();
+        return;
+      }
+      code_.push_back(
+          {*key, index++, accepted_orderings(c.op), c.pre_release.has_value()});
+      code_[header].pre_release |= c.pre_release.has_value();
+      if (c.op == GREATER || c.op == GREATER_EQUAL || c.op == EQUAL) {
+        lowest_major = std::max(lowest_major, c.major);
+      }
+      if (c.op == LESS || c.op == LESS_EQUAL || c.op == EQUAL) {
+        // Below M.0.0-0 means below M.
+        bool below_major = c.op == LESS && c.minor == 0 && c.patch == 0 &&
+                           c.pre_release == LOWEST_PRE_RELEASE;
+        if (below_major && c.major == 0) {
+          lowest_major = 1;
+          highest_major = 0;
+        } else {
+          highest_major = std::min(highest_major, c.major - below_major);
+        }
+      }
+    }
+    code_[header].key = lowest_major << 32 | highest_major;
+  }
+}
+
+bool compiled_range::test(const version& v) const noexcept {
+  // Components are decoded on first use: most comparisons are settled by the
+  // major alone.
+  uint64_t components[3];
+  std::string_view texts[3] = {v.major, v.minor, v.patch};
+  int decoded = 0;
+  auto decode_next = [&]() {
+    auto value = component_value(texts[decoded]);
+    if (!value.has_value() || *value >= PACKED_COMPONENT_LIMIT) {
+      return false;
+    }
+    components[decoded++] = *value;
+    return true;
+  };
+  if (!packed_ || !decode_next()) {
+    return source_.test(v);
+  }
+  bool pre_release = v.pre_release.has_value();
+  for (size_t i = 0; i < code_.size(); i += 1 + code_[i].operand) {
+    const instruction& header = code_[i];
+    if (components[0] < (header.key >> 32) ||
+        components[0] > (header.key & UINT32_MAX) ||
+        (pre_release && !header.pre_release)) {
+      continue;
+    }
+    bool passed = true;
+    // A pre-release may need a bound with a pre-release on its
+    // major.minor.patch.
+    bool allowed = !pre_release || header.accept == 0;
+    for (size_t j = i + 1; j <= i + header.operand && passed; j++) {
+      const instruction& bound = code_[j];
+      int order = 0;
+      for (int part = 0; part < 3 && order == 0; part++) {
+        if (part == decoded && !decode_next()) {
+          return source_.test(v);
+        }
+        uint64_t limit = (bound.key >> PACKED_SHIFTS[part]) &
+                         (PACKED_COMPONENT_LIMIT - 1);
+        order = (components[part] > limit) - (components[part] < limit);
+      }
+      if (order == 0) {
+        if (pre_release && bound.pre_release) {
+          auto cmp = compare_pre_release(
+              v.pre_release, source_.comparators_[bound.operand].pre_release);
+          order = (cmp > 0) - (cmp < 0);
+          allowed = true;
+        } else {
+          // A release ranks above the pre-releases of its major.minor.patch.
+          order = int(bound.pre_release) - int(pre_release);
+        }
+      }
+      passed = (bound.accept >> (order + 1)) & 1;
+    }
+    if (passed && allowed) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::expected<const compiled_range*, range_error> range_cache::get(
+    std::string_view text) {
+  auto spelling = spellings_.find(text);
+  if (spelling != spellings_.end()) {
+    return spelling->second;
+  }
+  auto parsed = parse_range(text, options_, resource_);
+  if (!parsed.has_value()) {
+    return std::unexpected(parsed.error());
+  }
+  auto entry =
+      compiled_.try_emplace(parsed->canonical(resource_), std::move(*parsed))
+          .first;
+  spellings_.emplace(text, &entry->second);
+  return &entry->second;
+}
+
+// A comparator set reduced to its tightest lower and upper bounds, where an
+// exact version is both, inclusive.
+struct interval {
+  std::optional<comparator> lower;
+  std::optional<comparator> upper;
+  // Whether pre-releases never satisfy the set, so that its "<M.m.p-0"
+  // bounds are written as "<M.m.p".
+  bool releases_only = false;
+  bool empty = false;
+
+  friend bool operator==(const interval&, const interval&) = default;
+};
+
+// Whether `a` excludes more versions than `b`, as a lower or upper bound.
+static bool tighter_lower(const comparator& a,
+                          const comparator& b) noexcept {
+  auto cmp = compare_bounds(a, b);
+  return cmp > 0 || (cmp == 0 && a.op == GREATER && b.op != GREATER);
+}
+static bool tighter_upper(const comparator& a,
+                          const comparator& b) noexcept {
+  auto cmp = compare_bounds(a, b);
+  return cmp < 0 || (cmp == 0 && a.op == LESS && b.op != LESS);
+}
+
+// Keeping only the tightest bounds never changes which pre-releases pass:
+// a dropped bound with a pre-release lets one pass only when it is within
+// the kept bound on the same side, which then has the same major.minor.patch
+// and a pre-release of its own.
+static interval tighten(std::span<const comparator> set,
+                        bool releases_only) {
+  interval result;
+  result.releases_only = releases_only;
+  auto add_lower = [&result](const comparator& c) {
+    if (!result.lower.has_value() || tighter_lower(c, *result.lower)) {
+      result.lower = c;
+    }
+  };
+  auto add_upper = [&result](const comparator& c) {
+    if (!result.upper.has_value() || tighter_upper(c, *result.upper)) {
+      result.upper = c;
+    }
+  };
+  for (comparator c : set) {
+    if (c.op == EQUAL) {
+      c.op = GREATER_EQUAL;
+      add_lower(c);
+      c.op = LESS_EQUAL;
+      add_upper(c);
+    } else if (c.op == GREATER || c.op == GREATER_EQUAL) {
+      add_lower(c);
+    } else {
+      if (releases_only && c.op == LESS) {
+        c.pre_release.reset();
+      }
+      add_upper(c);
+    }
+  }
+  // >=0.0.0 bounds nothing when pre-releases never pass.
+  if (releases_only && result.lower == comparator{}) {
+    result.lower.reset();
+  }
+  if (result.lower.has_value() && result.upper.has_value()) {
+    auto cmp = compare_bounds(*result.lower, *result.upper);
+    result.empty = cmp > 0 || (cmp == 0 && (result.lower->op == GREATER ||
+                                            result.upper->op == LESS));
+  }
+  return result;
+}
+
+// Orders intervals by lower bound, unbounded first.
+static bool lower_less(const interval& a, const interval& b) noexcept {
+  if (!a.lower.has_value() || !b.lower.has_value()) {
+    return !a.lower.has_value() && b.lower.has_value();
+  }
+  if (auto cmp = compare_bounds(*a.lower, *b.lower); cmp != 0) return cmp < 0;
+  return a.lower->op == GREATER_EQUAL && b.lower->op == GREATER;
+}
+
+// Whether `b`, starting no lower than `a`, overlaps or touches it.
+static bool connected(const interval& a, const interval& b) noexcept {
+  if (!a.upper.has_value() || !b.lower.has_value()) {
+    return true;
+  }
+  auto cmp = compare_bounds(*b.lower, *a.upper);
+  return cmp < 0 ||
+         (cmp == 0 && (b.lower->op != GREATER || a.upper->op != LESS));
+}
+
+// Writes an interval in the shortest form that parses back to it.
+template <typename String>
+void append_interval(String& out, const interval& i, bool include_prerelease) {
+  static constexpr std::string_view ops[] = {"<", "<=", ">", ">=", ""};
+  if (!i.lower.has_value() && !i.upper.has_value()) {
+    out += '*';
+    return;
+  }
+  if (i.lower.has_value() && i.upper.has_value()) {
+    const comparator& lower = *i.lower;
+    const comparator& upper = *i.upper;
+    if (lower.op == GREATER_EQUAL && upper.op == LESS_EQUAL) {
+      append_bound(out, lower);
+      if (compare_bounds(lower, upper) != 0) {
+        out += " - ";
+        append_bound(out, upper);
+      }
+      return;
+    }
+    if (lower.op == GREATER_EQUAL && upper.op == LESS) {
+      // The bounds that desugar() gives x-ranges, carets and tildes.
+      std::optional<std::string_view> partial_floor;
+      std::optional<std::string_view> upper_floor;
+      if (include_prerelease) {
+        partial_floor = LOWEST_PRE_RELEASE;
+      }
+      if (!i.releases_only) {
+        upper_floor = LOWEST_PRE_RELEASE;
+      }
+      auto upper_is = [&](uint64_t major, uint64_t minor, uint64_t patch) {
+        return upper == comparator{LESS, major, minor, patch, upper_floor};
+      };
+      auto next = [](uint64_t value) {
+        return value == UINT64_MAX ? 0 : value + 1;
+      };
+      auto write = [&](std::string_view prefix) {
+        out += prefix;
+        append_bound(out, lower);
+      };
+      uint64_t major = lower.major, minor = lower.minor, patch = lower.patch;
+      if (lower.pre_release == partial_floor && minor == 0 && patch == 0 &&
+          upper_is(next(major), 0, 0)) {
+        append_number(out, major);
+        out += ".x";
+      } else if (lower.pre_release == partial_floor && patch == 0 &&
+                 upper_is(major, next(minor), 0)) {
+        append_number(out, major);
+        out += '.';
+        append_number(out, minor);
+        out += ".x";
+      } else if (major != 0 ? upper_is(next(major), 0, 0)
+                 : minor != 0 ? upper_is(0, next(minor), 0)
+                              : upper_is(0, 0, next(patch))) {
+        write("^");
+      } else if (upper_is(major, next(minor), 0)) {
+        write("~");
+      } else {
+        write(">=");
+        out += " <";
+        append_bound(out, upper);
+      }
+      return;
+    }
+  }
+  if (i.lower.has_value()) {
+    out += ops[i.lower->op];
+    append_bound(out, *i.lower);
+  }
+  if (i.upper.has_value()) {
+    if (i.lower.has_value()) {
+      out += ' ';
+    }
+    out += ops[i.upper->op];
+    append_bound(out, *i.upper);
+  }
+}
+
+// An empty String, allocating from `resource` when it can.
+template <typename String>
+String empty_string(std::pmr::memory_resource* resource) {
+  if constexpr (std::is_same_v<String, std::pmr::string>) {
+    return String(resource);
+  } else {
+    return String();
+  }
+}
+
+// The resource that the scratch space for writing into `output` comes from.
+static std::pmr::memory_resource* resource_of(const std::string&) {
+  return std::pmr::get_default_resource();
+}
+static std::pmr::memory_resource* resource_of(const std::pmr::string& output) {
+  return output.get_allocator().resource();
+}
+
+template <typename String>
+std::string_view simplify_into(const range& r, String& output) {
+  std::pmr::memory_resource* resource = resource_of(output);
+  bool include_prerelease = r.options().include_prerelease;
+  // Sets that pre-releases satisfy only through their bounds are merged with
+  // nothing, as a merged set would lose or gain some of those bounds.
+  std::pmr::vector<interval> mergeable(resource);
+  std::pmr::vector<interval> kept(resource);
+  for (size_t i = 0; i < r.size(); i++) {
+    auto set = r.set(i);
+    bool releases_only =
+        !include_prerelease &&
+        std::all_of(set.begin(), set.end(), [](const comparator& c) {
+          return !c.pre_release.has_value() ||
+                 (c.op == LESS && c.pre_release == LOWEST_PRE_RELEASE);
+        });
+    interval current = tighten(set, releases_only);
+    if (current.empty) {
+      continue;
+    }
+    if (include_prerelease || releases_only) {
+      mergeable.push_back(current);
+    } else if (std::find(kept.begin(), kept.end(), current) == kept.end()) {
+      kept.push_back(current);
+    }
+  }
+  std::sort(mergeable.begin(), mergeable.end(), lower_less);
+  std::pmr::vector<interval> merged(resource);
+  for (const interval& next : mergeable) {
+    if (merged.empty() || !connected(merged.back(), next)) {
+      merged.push_back(next);
+      continue;
+    }
+    interval& last = merged.back();
+    if (last.upper.has_value() &&
+        (!next.upper.has_value() || tighter_upper(*last.upper, *next.upper))) {
+      last.upper = next.upper;
+    }
+  }
+  kept.insert(kept.end(), merged.begin(), merged.end());
+  std::stable_sort(kept.begin(), kept.end(), lower_less);
+
+  output.clear();
+  for (const interval& i : kept) {
+    if (!output.empty()) {
+      output += " || ";
+    }
+    append_interval(output, i, include_prerelease);
+  }
+  if (kept.empty()) {
+    output = "<0.0.0-0";
+  }
+  if (r.text().size() <= output.size()) {
+    output = r.text();
+  }
+  return output;
+}
+
+std::string_view simplify(const range& r, std::string& output) {
+  return simplify_into(r, output);
+}
+
+std::string_view simplify(const range& r, std::pmr::string& output) {
+  return simplify_into(r, output);
+}
+
+// Writes a version as major.minor.patch[-pre-release].
+template <typename String>
+void append_version(String& out, const version& v) {
+  out += v.major;
+  out += '.';
+  out += v.minor;
+  out += '.';
+  out += v.patch;
+  if (v.pre_release.has_value()) {
+    out += '-';
+    out += *v.pre_release;
+  }
+}
+
+template <typename String>
+std::string_view simplify_into(const range& r,
+                               std::span<const version> universe,
+                               String& output) {
+  simplify_into(r, output);
+  std::pmr::memory_resource* resource = resource_of(output);
+  // Parsed again rather than copied, so that it allocates from `resource`.
+  compiled_range compiled(
+      parse_range(r.text(), r.options(), resource).value());
+  String runs = empty_string<String>(resource);
+  auto add_run = [&](size_t first, std::optional<size_t> last) {
+    if (!runs.empty()) {
+      runs += " || ";
+    }
+    if (last == first) {
+      append_version(runs, universe[first]);
+    } else if (!last.has_value()) {
+      runs += first == 0 ? "*" : ">=";
+      if (first != 0) {
+        append_version(runs, universe[first]);
+      }
+    } else if (first == 0) {
+      runs += "<=";
+      append_version(runs, universe[*last]);
+    } else {
+      append_version(runs, universe[first]);
+      runs += " - ";
+      append_version(runs, universe[*last]);
+    }
+  };
+  std::optional<size_t> first;
+  for (size_t i = 0; i < universe.size(); i++) {
+    if (compiled.test(universe[i])) {
+      first = first.value_or(i);
+    } else if (first.has_value()) {
+      add_run(*first, i - 1);
+      first.reset();
+    }
+  }
+  if (first.has_value()) {
+    add_run(*first, std::nullopt);
+  }
+  if (runs.empty()) {
+    runs = "<0.0.0-0";
+  }
+  if (runs.size() >= output.size()) {
+    return output;
+  }
+  auto parsed = parse_range(runs, r.options(), resource);
+  if (!parsed.has_value()) {
+    return output;
+  }
+  compiled_range candidate(std::move(*parsed));
+  for (const version& v : universe) {
+    if (candidate.test(v) != compiled.test(v)) {
+      return output;
+    }
+  }
+  output = std::move(runs);
+  return output;
+}
+
+std::string_view simplify(const range& r, std::span<const version> universe,
+                          std::string& output) {
+  return simplify_into(r, universe, output);
+}
+
+std::string_view simplify(const range& r, std::span<const version> universe,
+                          std::pmr::string& output) {
+  return simplify_into(r, universe, output);
+}
+
+constexpr size_t SATISFYING_CHUNK = 64;
+// The key of a major too large for a uint64_t.
+constexpr uint64_t UNKNOWN_MAJOR = UINT64_MAX;
+
+// max_satisfying() when `highest`, or else min_satisfying(). Versions are
+// keyed by their major, which settles most comparisons with the best so far;
+// equal and unknown majors fall back to operator<=>.
+static std::optional<version> best_satisfying(
+    std::span<const version> versions, const compiled_range& r, bool highest) {
+  const version* best = nullptr;
+  uint64_t best_key = UNKNOWN_MAJOR;
+  std::array<uint64_t, SATISFYING_CHUNK> keys;
+  for (size_t start = 0; start < versions.size(); start += SATISFYING_CHUNK) {
+    size_t count = std::min(SATISFYING_CHUNK, versions.size() - start);
+    for (size_t i = 0; i < count; i++) {
+      keys[i] = component_value(versions[start + i].major)
+                    .value_or(UNKNOWN_MAJOR);
+    }
+    // A chunk whose majors are all beyond the best one is skipped whole.
+    // The reduction has no branches, so that compilers vectorize it.
+    uint64_t lowest_key = UINT64_MAX;
+    uint64_t highest_key = 0;
+    for (size_t i = 0; i < count; i++) {
+      lowest_key = std::min(lowest_key, keys[i]);
+      highest_key = std::max(highest_key, keys[i]);
+    }
+    if (best != nullptr && best_key != UNKNOWN_MAJOR &&
+        (highest ? highest_key < best_key
+                 : lowest_key > best_key && highest_key != UNKNOWN_MAJOR)) {
+      continue;
+    }
+    for (size_t i = 0; i < count; i++) {
+      const version& v = versions[start + i];
+      if (best != nullptr) {
+        if (keys[i] != best_key && keys[i] != UNKNOWN_MAJOR &&
+            best_key != UNKNOWN_MAJOR) {
+          if (highest ? keys[i] < best_key : keys[i] > best_key) {
+            continue;
+          }
+        } else if (auto cmp = v <=> *best; highest ? cmp <= 0 : cmp >= 0) {
+          continue;
+        }
+      }
+      if (r.test(v)) {
+        best = &v;
+        best_key = keys[i];
+      }
+    }
+  }
+  if (best == nullptr) {
+    return std::nullopt;
+  }
+  return *best;
+}
+
+std::optional<version> max_satisfying(std::span<const version> versions,
+                                      const compiled_range& r) {
+  return best_satisfying(versions, r, true);
+}
+
+std::optional<version> max_satisfying(std::span<const version> versions,
+                                      const range& r) {
+  return best_satisfying(versions, compiled_range(r), true);
+}
+
+std::optional<version> min_satisfying(std::span<const version> versions,
+                                      const compiled_range& r) {
+  return best_satisfying(versions, r, false);
+}
+
+std::optional<version> min_satisfying(std::span<const version> versions,
+                                      const range& r) {
+  return best_satisfying(versions, compiled_range(r), false);
+}
+
+template <typename String>
+std::optional<String> minimum_of(std::string_view range,
+                                 std::pmr::memory_resource* resource) {
+  auto parsed = parse_range(range, {}, resource);
+  if (range.empty() || !parsed.has_value()) {
+    return std::nullopt;
+  }
+  auto satisfying = [&parsed](const comparator& bound) {
+    char digits[3][20];
+    std::string_view components[3];
+    uint64_t values[] = {bound.major, bound.minor, bound.patch};
+    for (int i = 0; i < 3; i++) {
+      auto end = std::to_chars(digits[i], digits[i] + 20, values[i]).ptr;
+      components[i] = std::string_view(digits[i], end - digits[i]);
+    }
+    return parsed->test(version{components[0], components[1], components[2],
+                                bound.pre_release, std::nullopt});
+  };
+  auto written = [resource](const comparator& bound) {
+    String result = empty_string<String>(resource);
+    append_bound(result, bound);
+    return result;
+  };
+  // As npm's minVersion(): 0.0.0 or 0.0.0-0 when they satisfy the range, or
+  // else the lowest of the greatest lower bounds of the sets.
+  for (const comparator& lowest :
+       {comparator{}, comparator{EQUAL, 0, 0, 0, LOWEST_PRE_RELEASE}}) {
+    if (satisfying(lowest)) {
+      return written(lowest);
+    }
+  }
+  // The pre-releases of >M.m.p-pre bounds, extended to the next one.
+  std::pmr::deque<std::pmr::string> successors(resource);
+  std::optional<comparator> result;
+  for (size_t i = 0; i < parsed->size(); i++) {
+    std::optional<comparator> set_lowest;
+    bool overflow = false;
+    for (const comparator& c : parsed->set(i)) {
+      comparator bound = c;
+      if (c.op == GREATER && !c.pre_release.has_value()) {
+        overflow = overflow || c.patch == UINT64_MAX;
+        bound.patch++;
+      } else if (c.op == GREATER) {
+        successors.emplace_back(*c.pre_release).append(".0");
+        bound.pre_release = successors.back();
+      } else if (c.op != GREATER_EQUAL && c.op != EQUAL) {
+        continue;
+      }
+      if (!set_lowest.has_value() || compare_bounds(bound, *set_lowest) > 0) {
+        set_lowest = bound;
+      }
+    }
+    if (!overflow && set_lowest.has_value() &&
+        (!result.has_value() || compare_bounds(*set_lowest, *result) < 0)) {
+      result = set_lowest;
+    }
+  }
+  if (result.has_value() && satisfying(*result)) {
+    return written(*result);
+  }
+  return std::nullopt;
+}
+
+std::optional<std::string> minimum(std::string_view range) {
+  return minimum_of<std::string>(range, std::pmr::get_default_resource());
+}
+
+std::optional<std::pmr::string> minimum(std::string_view range,
+                                        std::pmr::memory_resource* resource) {
+  return minimum_of<std::pmr::string>(range, resource);
+}
+
+bool satisfies(std::string_view version, std::string_view range) {
+  return satisfies(version, range, {});
+}
+
+bool satisfies(std::string_view version, std::string_view range,
+               range_options options) {
+  auto parsed_version = parse(version);
+  if (!parsed_version.has_value()) {
+    return false;
+  }
+  auto parsed_range = parse_range(range, options);
+  return parsed_range.has_value() && parsed_range->test(*parsed_version);
+}
+
+std::vector<verify_failure> verify_lockfile(std::span<const locked_pair> pairs,
+                                            size_t threads) {
+  // Number the distinct range strings in order of first appearance.
+  std::unordered_map<std::string_view, size_t> ids;
+  std::vector<std::string_view> distinct;
+  std::vector<size_t> range_ids(pairs.size());
+  for (size_t i = 0; i < pairs.size(); i++) {
+    auto [id, inserted] = ids.try_emplace(pairs[i].range, distinct.size());
+    if (inserted) {
+      distinct.push_back(pairs[i].range);
+    }
+    range_ids[i] = id->second;
+  }
+
+  threads = std::max<size_t>(
+      1, std::min(threads, pairs.size() / (PARALLEL_VERIFY_THRESHOLD / 2)));
+  auto run_chunks = [threads](size_t count, const auto& work) {
+    if (threads == 1) {
+      work(0, 0, count);
+      return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+      workers.emplace_back(work, t, count * t / threads,
+                           count * (t + 1) / threads);
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  };
+
+  std::vector<std::optional<compiled_range>> compiled(distinct.size());
+  run_chunks(distinct.size(), [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto parsed = parse_range(distinct[i]);
+      if (parsed.has_value()) {
+        compiled[i].emplace(std::move(*parsed));
+      }
+    }
+  });
+
+  std::vector<std::vector<verify_failure>> failures(threads);
+  run_chunks(pairs.size(), [&](size_t chunk, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const auto& r = compiled[range_ids[i]];
+      if (!r.has_value()) {
+        failures[chunk].push_back({i, INVALID_LOCKED_RANGE});
+        continue;
+      }
+      auto v = parse(pairs[i].version);
+      if (!v.has_value()) {
+        failures[chunk].push_back({i, INVALID_LOCKED_VERSION});
+      } else if (!r->test(*v)) {
+        failures[chunk].push_back({i, UNSATISFIED});
+      }
+    }
+  });
+  for (size_t t = 1; t < threads; t++) {
+    failures[0].insert(failures[0].end(), failures[t].begin(),
+                       failures[t].end());
+  }
+  return std::move(failures[0]);
+}
+
+}  // namespace version_weaver
@@ -0,0 +1,371 @@
+#include "version_weaver/resolver.h"
+#include "version_weaver/range.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace version_weaver {
+
+std::expected<registry, resolve_error> registry::load(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return std::unexpected(REGISTRY_IO_ERROR);
+  }
+  std::ostringstream text;
+  text << in.rdbuf();
+  if (in.bad()) {
+    return std::unexpected(REGISTRY_IO_ERROR);
+  }
+  return parse(text.str());
+}
+
+std::expected<registry, resolve_error> registry::parse(std::string_view input) {
+  registry result;
+  auto text = std::make_shared<const std::string>(input);
+  std::string_view remaining = *text;
+  result.text_ = std::move(text);
+  std::vector<std::string_view> fields;
+  while (!remaining.empty()) {
+    size_t end = remaining.find('\n');
+    std::string_view line = remaining.substr(0, end);
+    remaining.remove_prefix(end == std::string_view::npos ? remaining.size()
+                                                          : end + 1);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    fields.clear();
+    while (true) {
+      size_t tab = line.find('\t');
+      fields.push_back(line.substr(0, tab));
+      if (tab == std::string_view::npos) break;
+      line.remove_prefix(tab + 1);
+    }
+    if (fields.size() < 2 || fields.size() % 2 != 0 || fields[0].empty()) {
+      return std::unexpected(INVALID_REGISTRY);
+    }
+    auto release = version_weaver::parse(fields[1]);
+    if (!release.has_value()) {
+      return std::unexpected(INVALID_REGISTRY);
+    }
+    registry_version entry{*release, {}};
+    for (size_t i = 2; i < fields.size(); i += 2) {
+      if (fields[i].empty() || !parse_range(fields[i + 1]).has_value()) {
+        return std::unexpected(INVALID_REGISTRY);
+      }
+      entry.dependencies.push_back({fields[i], fields[i + 1]});
+    }
+    auto [slot, inserted] =
+        result.index_.try_emplace(fields[0], result.packages_.size());
+    if (inserted) {
+      result.packages_.push_back({fields[0], {}});
+    }
+    result.packages_[slot->second].versions.push_back(std::move(entry));
+  }
+  for (auto& package : result.packages_) {
+    std::stable_sort(package.versions.begin(), package.versions.end(),
+                     [](const registry_version& a, const registry_version& b) {
+                       return a.release < b.release;
+                     });
+  }
+  return result;
+}
+
+const registry_package* registry::find(std::string_view name) const noexcept {
+  auto entry = index_.find(name);
+  return entry == index_.end() ? nullptr : &packages_[entry->second];
+}
+
+// The versions of a package that satisfy a range, highest first.
+struct candidate_list {
+  range parsed;
+  std::vector<const registry_version*> versions;
+};
+
+// Memoizes the candidate list of every (package, range) pair. Shared by the
+// threads resolving different subtrees.
+class candidate_cache {
+ public:
+  std::shared_ptr<const candidate_list> get(const registry_package& package,
+                                            std::string_view range_text) {
+    std::string key;
+    key.reserve(package.name.size() + 1 + range_text.size());
+    key.append(package.name);
+    key.push_back('\0');
+    key.append(range_text);
+    {
+      std::lock_guard lock(mutex_);
+      auto entry = lists_.find(key);
+      if (entry != lists_.end()) {
+        return entry->second;
+      }
+    }
+    // Ranges were validated along with the registry and the manifest.
+    auto list = std::make_shared<candidate_list>(
+        candidate_list{parse_range(range_text).value(), {}});
+    for (auto it = package.versions.rbegin(); it != package.versions.rend();
+         ++it) {
+      if (list->parsed.test(it->release)) {
+        list->versions.push_back(&*it);
+      }
+    }
+    std::lock_guard lock(mutex_);
+    return lists_.try_emplace(std::move(key), std::move(list)).first->second;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const candidate_list>> lists_;
+};
+
+// Resolves the subtree of one manifest entry.
+//
+// A (package, range) pair that failed is remembered with the packages its
+// search looked at. While none of them has a version in the subtree, asking
+// for the pair again would repeat the same search, so it fails at once. A
+// failure that relied on reusing a version chosen before its search started
+// is not remembered. Neither is a failure looked up while one of its packages
+// has a version in the subtree, such as an ancestor that a dependency cycle
+// leads back to. Those searches run again: a chain of d such pairs with k
+// versions each is still explored k^d times.
+class subtree_resolver {
+ public:
+  subtree_resolver(const package_lookup& lookup, candidate_cache& cache)
+      : lookup_(lookup), cache_(cache) {}
+
+  std::optional<size_t> resolve(std::string_view name,
+                                std::string_view range_text) {
+    const registry_package* package = lookup_(name);
+    if (package == nullptr) {
+      return std::nullopt;
+    }
+    looked_at_.push_back(package);
+    auto candidates = cache_.get(*package, range_text);
+    // Deduplicate: reuse a version already in the subtree when it fits.
+    for (size_t index : selected_[package->name]) {
+      if (candidates->parsed.test(nodes[index].release)) {
+        first_reused_ = std::min(first_reused_, index);
+        return index;
+      }
+    }
+    failure_key key{package, range_text};
+    auto failure = failures_.find(key);
+    if (failure != failures_.end() && none_selected(failure->second)) {
+      looked_at_.insert(looked_at_.end(), failure->second.begin(),
+                        failure->second.end());
+      return std::nullopt;
+    }
+    size_t first_node = nodes.size();
+    size_t first_looked_at = looked_at_.size() - 1;
+    size_t outer_reused = std::exchange(first_reused_, SIZE_MAX);
+    auto result = search(*package, *candidates);
+    if (!result.has_value() && first_reused_ >= first_node) {
+      std::vector<const registry_package*> packages(
+          looked_at_.begin() + first_looked_at, looked_at_.end());
+      std::ranges::sort(packages);
+      packages.erase(std::ranges::unique(packages).begin(), packages.end());
+      failures_.try_emplace(key, std::move(packages));
+    }
+    first_reused_ = std::min(first_reused_, outer_reused);
+    return result;
+  }
+
+  std::vector<resolved_package> nodes;
+
+ private:
+  struct failure_key {
+    const registry_package* package;
+    std::string_view range;
+    bool operator==(const failure_key&) const = default;
+  };
+
+  struct failure_key_hash {
+    size_t operator()(const failure_key& key) const noexcept {
+      return size_t(hash_finalize(
+          hash_bytes(key.range, reinterpret_cast<uintptr_t>(key.package))));
+    }
+  };
+
+  // Takes the highest candidate whose dependencies all resolve.
+  std::optional<size_t> search(const registry_package& package,
+                               const candidate_list& candidates) {
+    for (const registry_version* candidate : candidates.versions) {
+      size_t index = nodes.size();
+      nodes.push_back({package.name, candidate->release, {}});
+      selected_[package.name].push_back(index);
+      bool resolved = true;
+      for (const dependency& d : candidate->dependencies) {
+        auto child = resolve(d.name, d.range);
+        if (!child.has_value()) {
+          resolved = false;
+          break;
+        }
+        nodes[index].dependencies.push_back(*child);
+      }
+      if (resolved) {
+        return index;
+      }
+      // Backtrack: drop everything chosen for this candidate, newest first.
+      while (nodes.size() > index) {
+        selected_[nodes.back().name].pop_back();
+        nodes.pop_back();
+      }
+    }
+    return std::nullopt;
+  }
+
+  bool none_selected(
+      const std::vector<const registry_package*>& packages) const {
+    return std::ranges::none_of(packages, [this](const auto* package) {
+      auto chosen = selected_.find(package->name);
+      return chosen != selected_.end() && !chosen->second.empty();
+    });
+  }
+
+  const package_lookup& lookup_;
+  candidate_cache& cache_;
+  std::unordered_map<std::string_view, std::vector<size_t>> selected_;
+  // The packages that every search so far looked at, in order, so that those
+  // of the search in progress are a suffix.
+  std::vector<const registry_package*> looked_at_;
+  // The lowest index of a node that the search in progress reused.
+  size_t first_reused_ = SIZE_MAX;
+  // The failed pairs, with the packages their searches looked at.
+  std::unordered_map<failure_key, std::vector<const registry_package*>,
+                     failure_key_hash>
+      failures_;
+};
+
+struct package_key {
+  std::string_view name;
+  version release;
+};
+
+struct package_key_hash {
+  size_t operator()(const package_key& key) const noexcept {
+    return size_t(
+        hash_finalize(hash_bytes(key.name, identity_hash(key.release))));
+  }
+};
+
+struct package_key_equal {
+  bool operator()(const package_key& a, const package_key& b) const noexcept {
+    return a.name == b.name && identical(a.release, b.release);
+  }
+};
+
+std::expected<resolution, resolve_error> resolve(
+    const registry& packages, std::span<const dependency> manifest,
+    resolve_options options) {
+  return resolve(
+      [&packages](std::string_view name) { return packages.find(name); },
+      manifest, options);
+}
+
+std::expected<resolution, resolve_error> resolve(
+    const package_lookup& lookup, std::span<const dependency> manifest,
+    resolve_options options) {
+  for (const dependency& d : manifest) {
+    if (!parse_range(d.range).has_value()) {
+      return std::unexpected(INVALID_MANIFEST_RANGE);
+    }
+  }
+
+  candidate_cache cache;
+  std::vector<std::vector<resolved_package>> subtrees(manifest.size());
+  std::vector<std::optional<size_t>> subtree_roots(manifest.size());
+  std::atomic<size_t> next{0};
+  auto work = [&]() {
+    for (size_t i = next++; i < manifest.size(); i = next++) {
+      subtree_resolver resolver(lookup, cache);
+      subtree_roots[i] = resolver.resolve(manifest[i].name, manifest[i].range);
+      subtrees[i] = std::move(resolver.nodes);
+    }
+  };
+  size_t threads = std::min(options.threads, manifest.size());
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; t++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (!std::ranges::all_of(subtree_roots, [](const auto& root) {
+        return root.has_value();
+      })) {
+    return std::unexpected(UNRESOLVABLE);
+  }
+
+  // Merge the subtrees in manifest order. A package that several subtrees
+  // chose keeps the dependencies of the first one.
+  resolution merged;
+  std::unordered_map<package_key, size_t, package_key_hash, package_key_equal>
+      ids;
+  std::vector<size_t> remap;
+  std::vector<bool> owned;
+  for (size_t s = 0; s < subtrees.size(); s++) {
+    auto& nodes = subtrees[s];
+    remap.assign(nodes.size(), 0);
+    owned.assign(nodes.size(), false);
+    for (size_t i = 0; i < nodes.size(); i++) {
+      auto [id, inserted] = ids.try_emplace({nodes[i].name, nodes[i].release},
+                                            merged.packages.size());
+      if (inserted) {
+        merged.packages.push_back({nodes[i].name, nodes[i].release, {}});
+      }
+      remap[i] = id->second;
+      owned[i] = inserted;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+      if (owned[i]) {
+        for (size_t child : nodes[i].dependencies) {
+          merged.packages[remap[i]].dependencies.push_back(remap[child]);
+        }
+      }
+    }
+    merged.roots.push_back(remap[*subtree_roots[s]]);
+  }
+
+  // Drop the packages that only the discarded dependency lists reached.
+  constexpr size_t UNREACHED = SIZE_MAX;
+  std::vector<size_t> order(merged.packages.size(), UNREACHED);
+  std::vector<size_t> queue;
+  for (size_t root : merged.roots) {
+    if (order[root] == UNREACHED) {
+      order[root] = queue.size();
+      queue.push_back(root);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    for (size_t child : merged.packages[queue[head]].dependencies) {
+      if (order[child] == UNREACHED) {
+        order[child] = queue.size();
+        queue.push_back(child);
+      }
+    }
+  }
+  resolution result;
+  result.packages.reserve(queue.size());
+  for (size_t id : queue) {
+    auto& package = merged.packages[id];
+    for (size_t& child : package.dependencies) {
+      child = order[child];
+    }
+    result.packages.push_back(std::move(package));
+  }
+  for (size_t root : merged.roots) {
+    result.roots.push_back(order[root]);
+  }
+  return result;
+}
+
+}  // namespace version_weaver
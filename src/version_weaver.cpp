@@ -1,84 +1,207 @@
 #include "version_weaver.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cctype>
 #include <charconv>
-#include <format>
+#include <cstring>
 #include <regex>
+#include <thread>
+#include <vector>
 
 namespace version_weaver {
 bool validate(std::string_view version) { return parse(version).has_value(); }
 
-std::optional<std::string> coerce(std::string_view version) {
-  if (version.empty()) {
-    return std::nullopt;
-  }
-
-  // Regular expression to match major, minor, and patch components
-  std::regex semverRegex(R"((\d+)(?:\.(\d+))?(?:\.(\d+))?)");
-  std::smatch match;
-  std::string version_str(version);
-
-  if (std::regex_search(version_str, match, semverRegex)) {
-    std::string major =
-        std::to_string(std::stoll(match[1].str()));  // First number
-    std::string minor = match[2].matched
-                            ? std::to_string(std::stoll(match[2].str()))
-                            : "0";  // Second number or "0"
-    std::string patch = match[3].matched
-                            ? std::to_string(std::stoll(match[3].str()))
-                            : "0";  // Third number or "0"
+// Whether one of the eight bytes of `word` is a digit, with no false
+// positives ("hasbetween" from Bit Twiddling Hacks).
+static constexpr bool has_digit(uint64_t word) noexcept {
+  constexpr uint64_t ones = ~uint64_t{0} / 255;
+  constexpr uint64_t below = '0' - 1;
+  constexpr uint64_t above = '9' + 1;
+  uint64_t low = word & ones * 127;
+  return ((ones * (127 + above) - low) & ~word & (low + ones * (127 - below)) &
+          ones * 128) != 0;
+}
 
-    return major + "." + minor + "." + patch;
+// The first digit of `text` at or after `from`, or text.size(). Runs of text
+// without digits are skipped eight bytes at a time.
+static size_t find_digit(std::string_view text, size_t from) noexcept {
+  while (from + 8 <= text.size()) {
+    uint64_t word;
+    std::memcpy(&word, text.data() + from, sizeof(word));
+    if (has_digit(word)) {
+      break;
+    }
+    from += 8;
   }
-
-  return std::nullopt;
+  while (from < text.size() && !is_digit(text[from])) {
+    from++;
+  }
+  return from;
 }
 
-constexpr bool is_digit(const char c) noexcept { return c >= '0' && c <= '9'; }
+// Whether a run of digits starts at `index` right after a single dot.
+static bool follows_dot(std::string_view text, size_t index) noexcept {
+  return index >= 2 && text[index - 1] == '.' && is_digit(text[index - 2]);
+}
 
-std::vector<std::string_view> split(const std::string_view &s) {
-  std::vector<std::string_view> parts;
-  size_t start = 0;
-  while (start < s.size()) {
-    size_t end = s.find_first_of(".-", start);
-    if (end == std::string_view::npos) {
-      parts.push_back(s.substr(start));
+// The version made of up to three dot-separated runs of digits in
+// [begin, end), as coerce() reads them.
+static coerced_version coerced_at(std::string_view text, size_t begin,
+                                  size_t end) {
+  coerced_version result{
+      begin, end - begin, {"0", "0", "0", std::nullopt, std::nullopt}};
+  std::string_view* components[] = {&result.normalized.major,
+                                    &result.normalized.minor,
+                                    &result.normalized.patch};
+  size_t index = begin;
+  for (std::string_view* component : components) {
+    if (index >= end) {
       break;
-    } else {
-      parts.push_back(s.substr(start, end - start));
     }
-    start = end + 1;
+    size_t digits = index;
+    while (digits < end && is_digit(text[digits])) {
+      digits++;
+    }
+    *component = trim_leading_zeroes(text.substr(index, digits - index));
+    index = digits + 1;
   }
-  return parts;
+  return result;
 }
 
-bool compareSemVer(const std::string_view &a, const std::string_view &b) {
-  auto a_parts = split(a);
-  auto b_parts = split(b);
-
-  size_t min_size = std::min(a_parts.size(), b_parts.size());
-  for (size_t i = 0; i < min_size; i++) {
-    bool a_is_digit = !a_parts[i].empty() && std::isdigit(a_parts[i][0]);
-    bool b_is_digit = !b_parts[i].empty() && std::isdigit(b_parts[i][0]);
+// Finds versions from the start: the first run of digits, followed by up to
+// two more runs, each after a single dot.
+template <typename Emit>
+void coerce_forward(std::string_view text, Emit emit) {
+  size_t index = find_digit(text, 0);
+  while (index < text.size()) {
+    size_t end = index;
+    for (int component = 0; component < 3; component++) {
+      if (component > 0 &&
+          (end + 1 >= text.size() || text[end] != '.' ||
+           !is_digit(text[end + 1]))) {
+        break;
+      }
+      end += component > 0;
+      while (end < text.size() && is_digit(text[end])) {
+        end++;
+      }
+    }
+    if (!emit(coerced_at(text, index, end))) {
+      return;
+    }
+    index = find_digit(text, end);
+  }
+}
 
-    if (a_is_digit && b_is_digit) {
-      int num_a = std::stoi(std::string(a_parts[i]));
-      int num_b = std::stoi(std::string(b_parts[i]));
-      if (num_a != num_b) {
-        return num_a < num_b;
+// Finds versions from the end, as npm's rtl option: the last run of digits,
+// preceded by up to two more runs, each before a single dot.
+template <typename Emit>
+void coerce_backward(std::string_view text, Emit emit) {
+  size_t end = text.size();
+  while (true) {
+    while (end > 0 && !is_digit(text[end - 1])) {
+      end--;
+    }
+    if (end == 0) {
+      return;
+    }
+    size_t begin = end;
+    for (int component = 0; component < 3; component++) {
+      if (component > 0) {
+        if (!follows_dot(text, begin)) {
+          break;
+        }
+        begin--;
       }
-    } else {
-      if (a_parts[i] != b_parts[i]) {
-        return a_parts[i] < b_parts[i];
+      while (begin > 0 && is_digit(text[begin - 1])) {
+        begin--;
       }
     }
+    if (!emit(coerced_at(text, begin, end))) {
+      return;
+    }
+    end = begin;
   }
+}
 
-  return a_parts.size() < b_parts.size();
+template <typename Emit>
+void coerce_each(std::string_view text, coerce_options options, Emit emit) {
+  if (options.rtl) {
+    coerce_backward(text, emit);
+  } else {
+    coerce_forward(text, emit);
+  }
 }
 
-std::optional<std::string> incrementVersion(std::string_view version) {
+std::optional<std::string> coerce(std::string_view version) {
+  return coerce(version, {});
+}
+
+// The first version coerce_each() finds, written into a new String.
+template <typename String, typename... Allocator>
+std::optional<String> coerce_first(std::string_view version,
+                                   coerce_options options,
+                                   const Allocator&... allocator) {
+  std::optional<String> result;
+  coerce_each(version, options, [&](const coerced_version& found) {
+    const auto& [major, minor, patch, pre_release, build] = found.normalized;
+    result.emplace(allocator...);
+    result->reserve(major.size() + minor.size() + patch.size() + 2);
+    result->append(major).append(".").append(minor).append(".").append(patch);
+    return false;
+  });
+  return result;
+}
+
+std::optional<std::string> coerce(std::string_view version,
+                                  coerce_options options) {
+  return coerce_first<std::string>(version, options);
+}
+
+std::optional<std::pmr::string> coerce(std::string_view version,
+                                       coerce_options options,
+                                       std::pmr::memory_resource* resource) {
+  return coerce_first<std::pmr::string>(version, options, resource);
+}
+
+void coerce_all(std::string_view text, std::vector<coerced_version>& output,
+                coerce_options options) {
+  output.clear();
+  coerce_each(text, options, [&output](const coerced_version& found) {
+    output.push_back(found);
+    return true;
+  });
+}
+
+constexpr inline bool is_numeric(std::string_view input) noexcept {
+  return !input.empty() && contains_only_digits(input);
+}
+
+// The concatenation of `parts`, in a String made from `allocator`.
+template <typename String, typename... Allocator>
+String joined(std::initializer_list<std::string_view> parts,
+              const Allocator&... allocator) {
+  String result(allocator...);
+  size_t size = 0;
+  for (std::string_view part : parts) {
+    size += part.size();
+  }
+  result.reserve(size);
+  for (std::string_view part : parts) {
+    result.append(part);
+  }
+  return result;
+}
+
+template <typename String, typename... Allocator>
+std::optional<String> increment_version(std::string_view version,
+                                        const Allocator&... allocator) {
+  // Surrounding whitespace and build metadata do not take part, as in parse().
+  trim_whitespace(&version);
+  version = version.substr(0, version.find('+'));
+
   // First, we look for the '-' character to separate the pre-release part.
   std::string_view numPart;
   std::string_view preRelease;
@@ -90,334 +213,297 @@ std::optional<std::string> incrementVersion(std::string_view version) {
     numPart = version;
   }
 
-  // divides numPart by the dot ('.') character
-  std::vector<std::string_view> parts;
+  // divides numPart by the dot ('.') character, keeping the first three
+  std::string_view parts[3];
+  size_t part_count = 0;
   size_t start = 0;
-  while (true) {
+  while (part_count < 3) {
     size_t dotPos = numPart.find('.', start);
     if (dotPos == std::string_view::npos) {
-      parts.push_back(numPart.substr(start));
+      parts[part_count++] = numPart.substr(start);
       break;
     }
-    parts.push_back(numPart.substr(start, dotPos - start));
+    parts[part_count++] = numPart.substr(start, dotPos - start);
     start = dotPos + 1;
   }
 
-  if (parts.empty()) return std::nullopt;
-
-  int major = 0, minor = 0, patch = 0;
-  try {
-    major = std::stoi(std::string(parts[0]));
-    if (parts.size() >= 2) minor = std::stoi(std::string(parts[1]));
-    if (parts.size() >= 3) patch = std::stoi(std::string(parts[2]));
-  } catch (...) {
+  std::string_view major = parts[0];
+  std::string_view minor = part_count >= 2 ? parts[1] : "0";
+  std::string_view patch = part_count >= 3 ? parts[2] : "0";
+  if (!is_numeric(major) || !is_numeric(minor)) {
     return std::nullopt;
   }
+  auto next_patch = increment_component(patch);
+  if (!next_patch.has_value()) {
+    return std::nullopt;
+  }
+  major = trim_leading_zeroes(major);
+  minor = trim_leading_zeroes(minor);
 
   // If there is a pre-release part, return the version in pre-release format
   // (for example “1.2.3-beta.0”)
   if (!preRelease.empty()) {
-    return std::format("{}.{}.{}-{}.0", major, minor, patch,
-                       std::string(preRelease));
+    return joined<String>({major, ".", minor, ".", trim_leading_zeroes(patch),
+                           "-", preRelease, ".0"},
+                          allocator...);
   }
 
   // if there is no pre-release, increment patch and return the result.
-  patch++;
-  return std::format("{}.{}.{}", major, minor, patch);
+  return joined<String>({major, ".", minor, ".", next_patch->view()},
+                        allocator...);
 }
 
-std::optional<std::string> decrementVersion(const std::string_view version) {
-  std::regex version_regex(R"((\d+)(?:\.(\d+))?(?:\.(\d+))?(?:-([\w\d.-]+))?)");
-  std::smatch match;
-  std::string version_str(version);
+std::optional<std::string> incrementVersion(std::string_view version) {
+  return increment_version<std::string>(version);
+}
 
-  if (std::regex_match(version_str, match, version_regex)) {
-    int major = std::stoi(match[1].str());
-    int minor = match[2].matched ? std::stoi(match[2].str()) : 0;
-    int patch = match[3].matched ? std::stoi(match[3].str()) : 0;
-    std::string preRelease = match[4].matched ? match[4].str() : "";
+std::optional<std::pmr::string> incrementVersion(
+    std::string_view version, std::pmr::memory_resource* resource) {
+  return increment_version<std::pmr::string>(version, resource);
+}
+
+template <typename String, typename... Allocator>
+std::optional<String> decrement_version(std::string_view version,
+                                        const Allocator&... allocator) {
+  std::regex version_regex(R"((\d+)(?:\.(\d+))?(?:\.(\d+))?(?:-([\w\d.-]+))?)");
+  std::match_results<std::string_view::const_iterator> match;
+
+  if (std::regex_match(version.begin(), version.end(), match, version_regex)) {
+    auto group = [&](size_t index, std::string_view unmatched) {
+      return match[index].matched
+                 ? version.substr(match.position(index), match.length(index))
+                 : unmatched;
+    };
+    std::string_view major = group(1, "0");
+    std::string_view minor = group(2, "0");
+    std::string_view patch = group(3, "0");
+    std::string_view preRelease = group(4, "");
 
     // If there is a pre-release (beta, alpha), minimize it.
     if (!preRelease.empty()) {
-      if (preRelease.find("beta") != std::string::npos) {
-        return match[1].str() + "." + match[2].str() + "." + match[3].str() +
-               "-alpha.0";
-      } else if (preRelease.find("alpha") != std::string::npos) {
-        return match[1].str() + "." + match[2].str() + "." + match[3].str() +
-               "-alpha.0";
+      if (preRelease.find("beta") != std::string_view::npos ||
+          preRelease.find("alpha") != std::string_view::npos) {
+        return joined<String>(
+            {major, ".", group(2, ""), ".", group(3, ""), "-alpha.0"},
+            allocator...);
       }
     }
 
     // Patch version to zero, but downgrade to minor or major if already 0
-    if (major > 0) {
-      return std::to_string(major + 1) + ".0.0";
-    } else if (minor > 0) {
-      return "0." + std::to_string(minor + 1) + ".0";
+    if (trim_leading_zeroes(major) != "0") {
+      auto next = increment_component(major);
+      if (!next) return std::nullopt;
+      return joined<String>({next->view(), ".0.0"}, allocator...);
+    } else if (trim_leading_zeroes(minor) != "0") {
+      auto next = increment_component(minor);
+      if (!next) return std::nullopt;
+      return joined<String>({"0.", next->view(), ".0"}, allocator...);
     }
-    return "0.0." + std::to_string(patch + 1);
+    auto next = increment_component(patch);
+    if (!next) return std::nullopt;
+    return joined<String>({"0.0.", next->view()}, allocator...);
   }
 
   return std::nullopt;
 }
 
-// Checks whether the candidate meets the given constraint.
-bool satisfies_constraint(const std::string_view &candidate,
-                          const std::string_view &op,
-                          const std::string_view &version) {
-  if (op == ">") {
-    // must be equal to or higher than the candidate.
-    return compareSemVer(version, candidate) && (candidate != version);
-  } else if (op == ">=") {
-    return candidate == version || !compareSemVer(candidate, version);
-  } else if (op == "<") {
-    return compareSemVer(candidate, version);
-  } else if (op == "<=") {
-    return candidate == version || !compareSemVer(version, candidate);
-  }
-  return false;
-}
-
-std::optional<std::string> computeCaretUpperBound(
-    const std::string_view &version) {
-  auto coercedOpt = coerce(version);
-  if (!coercedOpt.has_value()) return "";
-
-  const std::string_view &coerced = *coercedOpt;
-  std::vector<std::string> parts;
-  std::string token;
-
-  for (char c : coerced) {
-    if (c == '.') {
-      parts.push_back(token);
-      token.clear();
-    } else {
-      token.push_back(c);
-    }
-  }
-  parts.push_back(token);
-
-  if (parts.size() < 3) {
-    return "";
-  }
-
-  int major = std::stoi(parts[0]);
-  int minor = std::stoi(parts[1]);
-  int patch = std::stoi(parts[2]);
-
-  if (major > 0) {
-    return std::to_string(major + 1) + ".0.0";
-  } else if (minor > 0) {
-    return "0." + std::to_string(minor + 1) + ".0";
-  }
-  return std::to_string(major) + "." + std::to_string(minor) + "." +
-         std::to_string(patch + 1);
-}
-
-std::string computeTildeUpperBound(const std::string_view &version) {
-  auto coercedOpt = coerce(version);
-
-  if (!coercedOpt) return "";
-
-  std::vector<std::string> parts;
-
-  size_t pos = 0;
-  size_t dot_pos;
-  while (pos < version.size() &&
-         (dot_pos = version.find('.', pos)) != std::string::npos) {
-    parts.push_back(std::string(version.substr(pos, dot_pos - pos)));
-    pos = dot_pos + 1;
-  }
-
-  if (pos < version.size()) {
-    parts.push_back(std::string(version.substr(pos)));
-  }
-
-  int major = std::stoi(parts[0]);
-  int minor = std::stoi(parts[1]);
-
-  // Upper bound for Tilde: X.(Y+1).0
-  std::string upper =
-      std::to_string(major) + "." + std::to_string(minor + 1) + ".0";
-  return upper;
+std::optional<std::string> decrementVersion(const std::string_view version) {
+  return decrement_version<std::string>(version);
 }
 
-constexpr inline void trim_whitespace(std::string_view *input) noexcept {
-  while (!input->empty() && std::isspace(input->front())) {
-    input->remove_prefix(1);
-  }
-  while (!input->empty() && std::isspace(input->back())) {
-    input->remove_suffix(1);
-  }
+std::optional<std::pmr::string> decrementVersion(
+    std::string_view version, std::pmr::memory_resource* resource) {
+  return decrement_version<std::pmr::string>(version, resource);
 }
 
-std::optional<std::string> minimum(std::string_view range) {
-  if (range.empty()) return std::nullopt;
-
-  // If the entire expression is just "*" (possibly with surrounding spaces),
-  // return "0.0.0" directly.
-  std::string_view trimmed_range = range;
-  trim_whitespace(&trimmed_range);
-  if (trimmed_range.size() == 1 && trimmed_range[0] == '*') return "0.0.0";
-
-  // Support for the dash operator ("A - B" form)
-  std::regex dash_regex(
-      R"(^\s*([\d]+(?:\.[\d]+){0,2})\s*-\s*([\d]+(?:\.[\d]+){0,2})\s*$)");
-  std::smatch dash_match;
-  std::string range_str(range);
-  if (std::regex_match(range_str, dash_match, dash_regex)) {
-    return coerce(dash_match[1].str());
-  }
-
-  std::optional<std::string> bestCandidate;
-  std::regex or_regex(R"(\s*\|\|\s*)");
-  std::regex star_regex(R"(^\*$)");
-
-  std::sregex_token_iterator subIt(range_str.begin(), range_str.end(), or_regex,
-                                   -1);
-  std::sregex_token_iterator subEnd;
-
-  for (; subIt != subEnd; ++subIt) {
-    std::string subRange = subIt->str();
-    // Trim whitespace from the beginning and end
-    auto start = subRange.find_first_not_of(" \t\n\r");
-    if (start != std::string::npos) subRange = subRange.substr(start);
-    auto endpos = subRange.find_last_not_of(" \t\n\r");
-    if (endpos != std::string::npos) subRange = subRange.substr(0, endpos + 1);
+// Appends to a version_buffer, remembering whether the output overflowed.
+struct version_writer {
+  version_buffer &output;
+  bool overflow = false;
 
-    // If the sub-range is a star, the candidate is "0.0.0"
-    if (std::regex_match(subRange, star_regex)) {
-      if (!bestCandidate.has_value() ||
-          compareSemVer("0.0.0", *bestCandidate)) {
-        bestCandidate = "0.0.0";
-        continue;
-      }
+  void append(std::string_view text) noexcept {
+    if (text.size() > MAX_VERSION_LENGTH - output.size) {
+      overflow = true;
+      return;
     }
+    std::copy(text.begin(), text.end(), output.data + output.size);
+    output.size += text.size();
+  }
+};
+
+std::expected<std::string_view, parse_error> inc(const version &input,
+                                                 release_type release_type,
+                                                 version_buffer &output,
+                                                 std::string_view identifier,
+                                                 identifier_base base) {
+  if (!is_numeric(input.major)) {
+    return std::unexpected(parse_error::INVALID_MAJOR);
+  }
+  if (!is_numeric(input.minor)) {
+    return std::unexpected(parse_error::INVALID_MINOR);
+  }
+  if (!is_numeric(input.patch)) {
+    return std::unexpected(parse_error::INVALID_PATCH);
+  }
+  bool is_pre = release_type == PRE_MAJOR || release_type == PRE_MINOR ||
+                release_type == PRE_PATCH || release_type == PRE_RELEASE;
+  if (is_pre && (identifier.empty() ? base == BASE_NONE
+                                    : !valid_pre_release(identifier))) {
+    return std::unexpected(parse_error::INVALID_IDENTIFIER);
+  }
+
+  std::string_view major = input.major;
+  std::string_view minor = input.minor;
+  std::string_view patch = input.patch;
+  // At most one component is bumped, so a single buffer holds its digits.
+  component_buffer bumped;
+  auto bump = [&bumped](std::string_view &component) {
+    auto next = increment_component(component);
+    if (!next.has_value()) return false;
+    bumped = *next;
+    component = bumped.view();
+    return true;
+  };
+  auto is_zero = [](std::string_view component) {
+    return trim_leading_zeroes(component) == "0";
+  };
+  bool has_pre_release = input.pre_release.has_value();
+  // The pre-release that PRE_* types extend, if any is kept.
+  std::string_view pre_release;
 
-    // Capture constraints; includes "^" and "~" operators.
-    std::regex constraint_regex(R"((>=|>|<=|<|\^|~)\s*([\w\d.-]+))");
-    std::sregex_iterator it(subRange.begin(), subRange.end(), constraint_regex);
-    std::sregex_iterator itEnd;
-    std::vector<std::pair<std::string, std::string>> lowerConstraints;
-    std::vector<std::pair<std::string, std::string>> upperConstraints;
-
-    std::string candidate;
-
-    for (; it != itEnd; ++it) {
-      std::string op = (*it)[1].str();
-      std::string version = (*it)[2].str();
-      if (op == "^") {
-        // For caret, add a lower constraint ">= version" and an upper
-        // constraint based on caret rules.
-        lowerConstraints.push_back({">=", version});
-        auto upperBoundOpt = computeCaretUpperBound(version);
-        if (upperBoundOpt.has_value())
-          upperConstraints.push_back({"<", *upperBoundOpt});
-      } else if (op == "~") {
-        // For tilde, add a lower constraint ">= version" and an upper
-        // constraint based on tilde rules.
-        lowerConstraints.push_back({">=", version});
-        std::string upperBound = computeTildeUpperBound(version);
-        if (!upperBound.empty()) upperConstraints.push_back({"<", upperBound});
-      } else if (op == ">" || op == ">=") {
-        lowerConstraints.push_back({op, version});
-      } else {
-        upperConstraints.push_back({op, version});
+  switch (release_type) {
+    case MAJOR:
+    case PRE_MAJOR:
+      if (release_type == PRE_MAJOR || !is_zero(minor) || !is_zero(patch) ||
+          !has_pre_release) {
+        if (!bump(major)) return std::unexpected(parse_error::INVALID_MAJOR);
       }
-    }
-
-    std::regex anyConstraint(R"(>=|>|<=|<|\^|~)");
-    // If there are no constraints in the sub-range (e.g., "1.0.x", "1.x",
-    // "=1.0.0", etc.), then the candidate is the normalized form of the
-    // sub-range.
-    if (!std::regex_search(subRange, anyConstraint)) {
-      auto c = coerce(subRange);
-      candidate = c.has_value() ? *c : subRange;
-    } else if (!lowerConstraints.empty()) {
-      for (auto &lc : lowerConstraints) {
-        // For ">" operator, use incrementVersion; for ">=" simply use the
-        // version.
-        std::string cur = (lc.first == ">")
-                              ? incrementVersion(lc.second).value_or(lc.second)
-                              : lc.second;
-        if (candidate.empty() || compareSemVer(candidate, cur)) candidate = cur;
+      minor = "0";
+      patch = "0";
+      break;
+    case MINOR:
+    case PRE_MINOR:
+      if (release_type == PRE_MINOR || !is_zero(patch) || !has_pre_release) {
+        if (!bump(minor)) return std::unexpected(parse_error::INVALID_MINOR);
       }
-    } else {
-      candidate = "0.0.0";
-    }
-
-    bool valid = true;
-    for (auto &[op, version] : upperConstraints) {
-      // Special case: if the constraint is "<0.0.0-beta" and the candidate is
-      // "0.0.0", change the candidate to "0.0.0-0".
-      if (op == "<" && version == "0.0.0-beta" && candidate == "0.0.0") {
-        candidate = "0.0.0-0";
+      patch = "0";
+      break;
+    case PATCH:
+    case PRE_PATCH:
+      if (release_type == PRE_PATCH || !has_pre_release) {
+        if (!bump(patch)) return std::unexpected(parse_error::INVALID_PATCH);
       }
-      if (!satisfies_constraint(candidate, op, version)) {
-        valid = false;
-        break;
+      break;
+    case PRE_RELEASE:
+      if (!has_pre_release) {
+        if (!bump(patch)) return std::unexpected(parse_error::INVALID_PATCH);
+      } else {
+        pre_release = *input.pre_release;
       }
-    }
-    if (valid && !candidate.empty()) {
-      if (!bestCandidate.has_value() ||
-          compareSemVer(candidate, *bestCandidate))
-        bestCandidate = candidate;
-    }
+      break;
+    case RELEASE:
+      if (!has_pre_release) {
+        return std::unexpected(parse_error::INVALID_RELEASE_TYPE);
+      }
+      break;
+    default:
+      return std::unexpected(parse_error::INVALID_RELEASE_TYPE);
   }
 
-  return bestCandidate;
-}
-
-std::expected<std::string, parse_error> inc(version input,
-                                            release_type release_type) {
-  switch (release_type) {
-    case MAJOR: {
-      int major_int;
-      auto [ptr, ec] =
-          std::from_chars(input.major.data(),
-                          input.major.data() + input.major.size(), major_int);
-      if (ec != std::errc()) {
-        return std::unexpected(parse_error::INVALID_MAJOR);
+  output.size = 0;
+  version_writer writer{output};
+  writer.append(trim_leading_zeroes(major));
+  writer.append(".");
+  writer.append(trim_leading_zeroes(minor));
+  writer.append(".");
+  writer.append(trim_leading_zeroes(patch));
+  if (is_pre) {
+    std::string_view base_digit = base == BASE_ONE ? "1" : "0";
+    writer.append("-");
+    size_t pre_release_start = output.size;
+    if (pre_release.empty()) {
+      writer.append(base_digit);
+    } else {
+      // Bump the last numeric identifier, or append a counter when there is
+      // none.
+      size_t counter_start = std::string_view::npos;
+      size_t counter_end = 0;
+      for (size_t start = 0; start <= pre_release.size();) {
+        size_t end = std::min(pre_release.find('.', start), pre_release.size());
+        if (is_numeric(pre_release.substr(start, end - start))) {
+          counter_start = start;
+          counter_end = end;
+        }
+        start = end + 1;
       }
-      auto incremented_major_int = major_int + 1;
-      auto major = std::to_string(incremented_major_int);
-      auto new_version = version_weaver::version{major, "0", "0"};
-      return new_version;
-    }
-    case MINOR: {
-      int minor_int;
-      auto [ptr, ec] =
-          std::from_chars(input.minor.data(),
-                          input.minor.data() + input.minor.size(), minor_int);
-      if (ec != std::errc()) {
-        return std::unexpected(parse_error::INVALID_MINOR);
+      if (counter_start != std::string_view::npos) {
+        auto counter = increment_component(
+            pre_release.substr(counter_start, counter_end - counter_start));
+        if (!counter.has_value()) {
+          return std::unexpected(parse_error::INVALID_INPUT);
+        }
+        writer.append(pre_release.substr(0, counter_start));
+        writer.append(counter->view());
+        writer.append(pre_release.substr(counter_end));
+      } else {
+        if (identifier == pre_release && base == BASE_NONE) {
+          return std::unexpected(parse_error::INVALID_IDENTIFIER);
+        }
+        writer.append(pre_release);
+        writer.append(".");
+        writer.append(base_digit);
       }
-      auto incremented_minor_int = minor_int + 1;
-      return version_weaver::version{
-          input.major, std::to_string(incremented_minor_int), "0"};
     }
-    case PATCH: {
-      if (input.pre_release) {
-        return version_weaver::version{input.major, input.minor, input.patch};
+    if (!identifier.empty() && !writer.overflow) {
+      // Switch to the requested identifier, keeping the counter when the
+      // pre-release already uses it: 1.2.3-beta.1 -> 1.2.3-beta.2 with "beta".
+      std::string_view written(output.data + pre_release_start,
+                               output.size - pre_release_start);
+      size_t first_dot = written.find('.');
+      std::string_view first = written.substr(0, first_dot);
+      std::string_view second;
+      if (first_dot != std::string_view::npos) {
+        second = written.substr(first_dot + 1);
+        second = second.substr(0, second.find('.'));
       }
-      int patch_int;
-      auto [ptr, ec] =
-          std::from_chars(input.patch.data(),
-                          input.patch.data() + input.patch.size(), patch_int);
-      if (ec != std::errc()) {
-        return std::unexpected(parse_error::INVALID_PATCH);
+      if (compare_identifiers(first, identifier) != 0 || !is_numeric(second)) {
+        output.size = pre_release_start;
+        writer.append(identifier);
+        if (base != BASE_NONE) {
+          writer.append(".");
+          writer.append(base_digit);
+        }
       }
-      auto incremented_patch_int = patch_int + 1;
-      return version_weaver::version{input.major, input.minor,
-                                     std::to_string(incremented_patch_int)};
     }
-    default:
-      return std::unexpected(parse_error::INVALID_RELEASE_TYPE);
   }
+  if (writer.overflow) {
+    return std::unexpected(parse_error::VERSION_LARGER_THAN_MAX_LENGTH);
+  }
+  return output.view();
+}
+
+std::expected<std::string, parse_error> inc(version input,
+                                            release_type release_type,
+                                            std::string_view identifier,
+                                            identifier_base base) {
+  version_buffer output;
+  auto result = inc(input, release_type, output, identifier, base);
+  if (!result.has_value()) {
+    return std::unexpected(result.error());
+  }
+  return std::string(*result);
 }
 
-constexpr inline bool contains_only_digits(std::string_view input) noexcept {
-  // Optimization opportunity: Replace this with a hash table lookup.
-  return input.find_first_not_of("0123456789") == std::string_view::npos;
+std::expected<std::pmr::string, parse_error> inc(
+    const version& input, release_type release_type,
+    std::pmr::memory_resource* resource, std::string_view identifier,
+    identifier_base base) {
+  version_buffer output;
+  auto result = inc(input, release_type, output, identifier, base);
+  if (!result.has_value()) {
+    return std::unexpected(result.error());
+  }
+  return std::pmr::string(*result, resource);
 }
 
 std::expected<version, parse_error> clean(std::string_view input) {
@@ -438,83 +524,328 @@ std::expected<version, parse_error> clean(std::string_view input) {
   return parse(range);
 }
 
-std::expected<version, parse_error> parse(std::string_view input) {
-  if (input.size() > MAX_VERSION_LENGTH) {
-    return std::unexpected(parse_error::VERSION_LARGER_THAN_MAX_LENGTH);
+struct sort_item {
+  uint64_t key;
+  size_t index;
+};
+
+// Sorts by precedence on a single thread. Each version is reduced to a key
+// holding its packed release triple and, in the lowest bit, whether it is a
+// release (releases rank above pre-releases of the same triple). The keys are
+// LSD radix sorted one byte at a time, skipping bytes that are the same for
+// every key. Returns false, leaving the span untouched, when the triples do
+// not fit in a single 64-bit key.
+static bool radix_sort_versions(std::span<version> versions) {
+  std::vector<sort_item> items(versions.size());
+  std::vector<std::array<uint64_t, 3>> triples(versions.size());
+  uint64_t max_major = 0, max_minor = 0, max_patch = 0;
+  for (size_t i = 0; i < versions.size(); i++) {
+    auto major = component_value(versions[i].major);
+    auto minor = component_value(versions[i].minor);
+    auto patch = component_value(versions[i].patch);
+    if (!major || !minor || !patch) {
+      return false;
+    }
+    triples[i] = {*major, *minor, *patch};
+    max_major = std::max(max_major, *major);
+    max_minor = std::max(max_minor, *minor);
+    max_patch = std::max(max_patch, *patch);
+  }
+  int minor_bits = std::bit_width(max_minor);
+  int patch_bits = std::bit_width(max_patch);
+  int total_bits = std::bit_width(max_major) + minor_bits + patch_bits + 1;
+  if (total_bits > 64) {
+    return false;
+  }
+  for (size_t i = 0; i < versions.size(); i++) {
+    uint64_t key = triples[i][0];
+    key = minor_bits == 0 ? key : (key << minor_bits) | triples[i][1];
+    key = patch_bits == 0 ? key : (key << patch_bits) | triples[i][2];
+    key = (key << 1) | (versions[i].pre_release.has_value() ? 0 : 1);
+    items[i] = {key, i};
+  }
+  triples = {};
+
+  std::vector<sort_item> buffer(items.size());
+  for (int shift = 0; shift < total_bits; shift += 8) {
+    std::array<size_t, 256> counts{};
+    for (const auto &item : items) {
+      counts[(item.key >> shift) & 0xff]++;
+    }
+    if (counts[(items[0].key >> shift) & 0xff] == items.size()) {
+      continue;
+    }
+    size_t offset = 0;
+    for (auto &count : counts) {
+      size_t next = offset + count;
+      count = offset;
+      offset = next;
+    }
+    for (const auto &item : items) {
+      buffer[counts[(item.key >> shift) & 0xff]++] = item;
+    }
+    items.swap(buffer);
+  }
+
+  std::vector<version> sorted(versions.size());
+  for (size_t i = 0; i < items.size(); i++) {
+    sorted[i] = versions[items[i].index];
+  }
+  // Pre-releases sharing a release triple are ordered by their identifiers.
+  for (size_t i = 0; i < items.size();) {
+    size_t j = i + 1;
+    while (j < items.size() && items[j].key == items[i].key) {
+      j++;
+    }
+    if (j - i > 1 && (items[i].key & 1) == 0) {
+      std::stable_sort(sorted.begin() + i, sorted.begin() + j,
+                       [](const version &a, const version &b) { return a < b; });
+    }
+    i = j;
   }
+  std::copy(sorted.begin(), sorted.end(), versions.begin());
+  return true;
+}
 
-  std::string_view input_copy = input;
-  trim_whitespace(&input_copy);
+static void sort_versions_sequential(std::span<version> versions) {
+  if (versions.size() < 2 || radix_sort_versions(versions)) {
+    return;
+  }
+  std::stable_sort(versions.begin(), versions.end(),
+                   [](const version &a, const version &b) { return a < b; });
+}
 
-  auto dot_iterator = input_copy.find('.');
-  if (dot_iterator == std::string_view::npos) {
-    // Only major exists. No minor or patch.
-    return std::unexpected(parse_error::INVALID_INPUT);
+void sort_versions(std::span<version> versions, size_t threads) {
+  if (threads <= 1 || versions.size() < PARALLEL_SORT_THRESHOLD) {
+    sort_versions_sequential(versions);
+    return;
+  }
+  threads = std::min(threads, versions.size() / (PARALLEL_SORT_THRESHOLD / 2));
+  // Sort contiguous partitions independently, then merge neighbours pairwise
+  // until a single sorted run is left.
+  std::vector<size_t> bounds;
+  for (size_t t = 0; t <= threads; t++) {
+    bounds.push_back(versions.size() * t / threads);
+  }
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&versions, &bounds, t]() {
+      sort_versions_sequential(
+          versions.subspan(bounds[t], bounds[t + 1] - bounds[t]));
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  while (bounds.size() > 2) {
+    workers.clear();
+    std::vector<size_t> merged;
+    for (size_t t = 0; t + 1 < bounds.size(); t += 2) {
+      merged.push_back(bounds[t]);
+      if (t + 2 >= bounds.size()) {
+        break;
+      }
+      workers.emplace_back([&versions, first = bounds[t], middle = bounds[t + 1],
+                            last = bounds[t + 2]]() {
+        std::inplace_merge(
+            versions.begin() + first, versions.begin() + middle,
+            versions.begin() + last,
+            [](const version &a, const version &b) { return a < b; });
+      });
+    }
+    merged.push_back(bounds.back());
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    bounds.swap(merged);
   }
-  version version;
-  auto major = input_copy.substr(0, dot_iterator);
+}
 
-  if (major.empty() || major.front() == '0') {
-    // Version components can not have leading zeroes.
-    return std::unexpected(parse_error::INVALID_INPUT);
+size_t unique_versions(std::span<version> versions) {
+  auto end = std::unique(versions.begin(), versions.end(),
+                         [](const version &a, const version &b) {
+                           return (a <=> b) == 0;
+                         });
+  return size_t(end - versions.begin());
+}
+
+pre_release_table::id pre_release_table::intern(
+    std::optional<std::string_view> pre_release) {
+  if (!pre_release.has_value()) {
+    return {};
   }
-  if (!contains_only_digits(major)) {
-    return std::unexpected(parse_error::INVALID_INPUT);
+  auto found = pre_releases_.find(*pre_release);
+  if (found != pre_releases_.end()) {
+    return found->second;
   }
-  version.major = major;
-  input_copy = input_copy.substr(dot_iterator + 1);
-  dot_iterator = input_copy.find('.');
-  if (dot_iterator == std::string_view::npos) {
-    // Only major and minor exists. No patch.
-    return std::unexpected(parse_error::INVALID_INPUT);
+  id result{uint32_t(keys_.size()), 0};
+  std::string_view remaining = *pre_release;
+  while (true) {
+    size_t dot = remaining.find('.');
+    std::string_view identifier = remaining.substr(0, dot);
+    auto value = component_value(identifier);
+    if (value.has_value() && *value < SYMBOL) {
+      keys_.push_back(uint32_t(*value));
+    } else {
+      keys_.push_back(SYMBOL | intern_identifier(identifier));
+    }
+    result.size++;
+    if (dot == std::string_view::npos) break;
+    remaining.remove_prefix(dot + 1);
   }
+  pre_releases_.emplace(*pre_release, result);
+  return result;
+}
 
-  auto minor = input_copy.substr(0, dot_iterator);
-  if (minor.empty() || (minor.front() == '0' && minor.size() > 1)) {
-    // Version components can not have leading zeroes.
-    return std::unexpected(parse_error::INVALID_INPUT);
+uint32_t pre_release_table::intern_identifier(std::string_view identifier) {
+  auto found = symbols_.find(identifier);
+  if (found != symbols_.end()) {
+    return found->second;
+  }
+  uint32_t symbol = uint32_t(symbol_text_.size());
+  // Map nodes do not move, so the key can be viewed.
+  symbol_text_.push_back(symbols_.emplace(identifier, symbol).first->first);
+  ranks_.push_back(UNRANKED);
+  unranked_.push_back(symbol);
+  // Ranking again costs a pass over every symbol, so it waits until the
+  // unranked ones are a 64th of them, which keeps interning O(log n)
+  // amortized.
+  if (unranked_.size() * 64 > order_.size()) {
+    rank_symbols();
+  }
+  return symbol;
+}
+
+void pre_release_table::rank_symbols() {
+  auto less = [this](uint32_t a, uint32_t b) {
+    return compare_identifiers(symbol_text_[a], symbol_text_[b]) < 0;
+  };
+  std::ranges::sort(unranked_, less);
+  // Each unranked symbol is placed by a binary search, so that the pass over
+  // the ranked ones only moves integers.
+  std::vector<uint32_t> merged;
+  merged.reserve(order_.size() + unranked_.size());
+  auto next = order_.begin();
+  for (uint32_t symbol : unranked_) {
+    auto position = std::lower_bound(next, order_.end(), symbol, less);
+    merged.insert(merged.end(), next, position);
+    merged.push_back(symbol);
+    next = position;
+  }
+  merged.insert(merged.end(), next, order_.end());
+  order_.swap(merged);
+  unranked_.clear();
+  for (size_t i = 0; i < order_.size(); i++) {
+    ranks_[order_[i]] = uint32_t(i);
   }
-  if (!contains_only_digits(minor)) {
-    return std::unexpected(parse_error::INVALID_INPUT);
+}
+
+std::strong_ordering pre_release_table::compare(id first,
+                                                id second) const noexcept {
+  if (first.size == 0 || second.size == 0) {
+    // A version without a pre-release ranks above one with a pre-release.
+    return second.size <=> first.size;
+  }
+  if (first.offset == second.offset) {
+    return std::strong_ordering::equal;
+  }
+  size_t shared = std::min(first.size, second.size);
+  for (size_t i = 0; i < shared; i++) {
+    uint32_t a = keys_[first.offset + i];
+    uint32_t b = keys_[second.offset + i];
+    if (a == b) {
+      continue;
+    }
+    // Numbers rank below symbols, whose ranks order them.
+    if ((a & SYMBOL) && (b & SYMBOL)) {
+      uint32_t first_rank = ranks_[a & ~SYMBOL];
+      uint32_t second_rank = ranks_[b & ~SYMBOL];
+      if (first_rank != UNRANKED && second_rank != UNRANKED) {
+        return first_rank <=> second_rank;
+      }
+      return compare_identifiers(symbol_text_[a & ~SYMBOL],
+                                 symbol_text_[b & ~SYMBOL]);
+    }
+    return a <=> b;
   }
-  version.minor = minor;
-  input_copy = input_copy.substr(dot_iterator + 1);
-  dot_iterator = input_copy.find_first_of("-+");
-  auto patch = (dot_iterator == std::string_view::npos)
-                   ? input_copy
-                   : input_copy.substr(0, dot_iterator);
-  if (patch.empty() || (patch.front() == '0' && patch.size() > 1)) {
-    return std::unexpected(parse_error::INVALID_INPUT);
+  return first.size <=> second.size;
+}
+
+// Orders numeric components, which have no leading zeroes.
+static std::strong_ordering compare_numeric(std::string_view a,
+                                            std::string_view b) {
+  if (a.size() != b.size()) {
+    return a.size() <=> b.size();
   }
-  if (!contains_only_digits(patch)) {
-    return std::unexpected(parse_error::INVALID_INPUT);
+  return a <=> b;
+}
+
+// Orders the line of `v` relative to the line of `major` (and `minor`).
+static std::strong_ordering compare_line(
+    const version &v, std::string_view major,
+    std::optional<std::string_view> minor) {
+  auto order = compare_numeric(v.major, major);
+  if (order != 0 || !minor.has_value()) {
+    return order;
   }
-  version.patch = patch;
+  return compare_numeric(v.minor, *minor);
+}
 
-  if (dot_iterator == std::string_view::npos) {
-    return version;
+// Fills in the latest version of the line at [begin, end).
+static release_line make_line(std::span<const version> sorted, size_t begin,
+                              size_t end) {
+  size_t latest = end - 1;
+  while (latest > begin && sorted[latest].pre_release.has_value()) {
+    latest--;
   }
-  bool is_pre_release = input_copy[dot_iterator] == '-';
-  input_copy = input_copy.substr(dot_iterator + 1);
-  if (is_pre_release) {
-    dot_iterator = input_copy.find('+');
-    auto prerelease = (dot_iterator == std::string_view::npos)
-                          ? input_copy
-                          : input_copy.substr(0, dot_iterator);
-    if (prerelease.empty()) {
-      return std::unexpected(parse_error::INVALID_INPUT);
+  if (sorted[latest].pre_release.has_value()) {
+    latest = end - 1;
+  }
+  return {begin, end, latest};
+}
+
+std::vector<release_line> release_lines(std::span<const version> sorted,
+                                        release_line_kind kind) {
+  std::vector<release_line> lines;
+  size_t begin = 0;
+  while (begin < sorted.size()) {
+    std::string_view major = sorted[begin].major;
+    std::optional<std::string_view> minor;
+    if (kind == MINOR_LINE) {
+      minor = sorted[begin].minor;
     }
-    version.pre_release = prerelease;
-    if (dot_iterator == std::string_view::npos) {
-      return version;
+    auto in_line = [major, minor](const version &v) {
+      return compare_line(v, major, minor) == 0;
+    };
+    // Gallop to a version past the line, then bisect the last step.
+    size_t step = 1;
+    while (begin + step < sorted.size() && in_line(sorted[begin + step])) {
+      step *= 2;
     }
-    input_copy = input_copy.substr(dot_iterator + 1);
-  }
-  if (input_copy.empty()) {
-    return std::unexpected(parse_error::INVALID_INPUT);
+    auto first = sorted.begin() + begin + step / 2 + 1;
+    auto last = sorted.begin() + std::min(begin + step, sorted.size());
+    size_t end = size_t(std::partition_point(first, last, in_line) -
+                        sorted.begin());
+    lines.push_back(make_line(sorted, begin, end));
+    begin = end;
+  }
+  return lines;
+}
+
+std::optional<release_line> find_release_line(
+    std::span<const version> sorted, std::string_view major,
+    std::optional<std::string_view> minor) {
+  auto first = std::partition_point(
+      sorted.begin(), sorted.end(),
+      [&](const version &v) { return compare_line(v, major, minor) < 0; });
+  auto last = std::partition_point(first, sorted.end(), [&](const version &v) {
+    return compare_line(v, major, minor) == 0;
+  });
+  if (first == last) {
+    return std::nullopt;
   }
-  version.build = input_copy;
-  return version;
+  return make_line(sorted, size_t(first - sorted.begin()),
+                   size_t(last - sorted.begin()));
 }
 
-}  // namespace version_weaver
\ No newline at end of file
+}  // namespace version_weaver
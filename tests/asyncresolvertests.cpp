@@ -0,0 +1,138 @@
+#include "version_weaver/async_resolver.h"
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+constexpr std::string_view REGISTRY = R"(app	1.0.0	lib	^1.0.0	util	~2.1.0
+lib	1.0.0	util	^2.0.0
+lib	1.4.0	util	^2.0.0
+lib	1.5.0	missing	^1.0.0
+lib	2.0.0	util	^3.0.0
+util	2.0.0
+util	2.1.3
+util	3.1.0
+cycle-a	1.0.0	cycle-b	^1.0.0
+cycle-b	1.0.0	cycle-a	^1.0.0
+broken	1.0.0	lib	>=3.0.0
+)";
+
+version_weaver::task<int> add(int a, int b) { co_return a + b; }
+
+version_weaver::task<int> sum_on(version_weaver::executor& pool) {
+  co_await pool.schedule();
+  int first = co_await add(1, 2);
+  int second = co_await add(first, 3);
+  co_return second;
+}
+
+version_weaver::task<std::vector<const version_weaver::registry_package*>>
+fetch_each(version_weaver::metadata_source& source,
+           version_weaver::executor& pool,
+           std::vector<std::string_view> names) {
+  std::vector<const version_weaver::registry_package*> found;
+  for (std::string_view name : names) {
+    found.push_back(co_await version_weaver::fetch(source, name, pool));
+  }
+  co_return found;
+}
+
+void expect_same(const version_weaver::resolution& a,
+                 const version_weaver::resolution& b) {
+  ASSERT_EQ(a.roots, b.roots);
+  ASSERT_EQ(a.packages.size(), b.packages.size());
+  for (size_t i = 0; i < a.packages.size(); i++) {
+    ASSERT_EQ(a.packages[i].name, b.packages[i].name);
+    ASSERT_TRUE(version_weaver::identical(a.packages[i].release,
+                                          b.packages[i].release));
+    ASSERT_EQ(a.packages[i].dependencies, b.packages[i].dependencies);
+  }
+}
+
+TEST(asyncresolvertests, task) {
+  version_weaver::executor pool(2);
+  ASSERT_EQ(version_weaver::sync_wait(add(2, 3)), 5);
+  ASSERT_EQ(version_weaver::sync_wait(sum_on(pool)), 6);
+}
+
+TEST(asyncresolvertests, fetch) {
+  auto packages = version_weaver::registry::parse(REGISTRY).value();
+  version_weaver::registry_source source(packages, 100us);
+  version_weaver::executor pool(1);
+  auto found = version_weaver::sync_wait(
+      fetch_each(source, pool, {"lib", "left-pad", "util"}));
+  ASSERT_EQ(found.size(), 3);
+  ASSERT_EQ(found[0], packages.find("lib"));
+  ASSERT_EQ(found[1], nullptr);
+  ASSERT_EQ(found[2], packages.find("util"));
+  ASSERT_EQ(source.fetch_count(), 3);
+  ASSERT_EQ(source.max_in_flight(), 1);
+}
+
+TEST(asyncresolvertests, resolve) {
+  auto packages = version_weaver::registry::parse(REGISTRY).value();
+  // Later packages arrive first.
+  version_weaver::registry_source source(packages, [](std::string_view name) {
+    return name == "util" ? 50us : 2000us;
+  });
+  version_weaver::executor pool(2);
+  for (std::vector<version_weaver::dependency> manifest :
+       {std::vector<version_weaver::dependency>{{"app", "*"},
+                                                {"util", "^2.0.0"}},
+        {{"lib", "^2.0.0"}, {"util", "~2.0.0"}},
+        {{"cycle-a", "^1.0.0"}}}) {
+    auto expected = version_weaver::resolve(packages, manifest);
+    auto result = version_weaver::sync_wait(
+        version_weaver::resolve_async(source, pool, manifest));
+    ASSERT_TRUE(expected.has_value());
+    ASSERT_TRUE(result.has_value());
+    expect_same(*result, *expected);
+  }
+
+  std::vector<version_weaver::dependency> broken = {{"broken", "*"}};
+  ASSERT_EQ(version_weaver::sync_wait(
+                version_weaver::resolve_async(source, pool, broken))
+                .error(),
+            version_weaver::UNRESOLVABLE);
+  std::vector<version_weaver::dependency> invalid = {{"lib", "=>1"}};
+  ASSERT_EQ(version_weaver::sync_wait(
+                version_weaver::resolve_async(source, pool, invalid))
+                .error(),
+            version_weaver::INVALID_MANIFEST_RANGE);
+}
+
+TEST(asyncresolvertests, overlap) {
+  // Two layers: every root depends on every package of the second layer.
+  std::string text;
+  const size_t width = 20;
+  for (size_t i = 0; i < width; i++) {
+    text += "leaf-" + std::to_string(i) + "\t1.0.0\n";
+    text += "leaf-" + std::to_string(i) + "\t1.1.0\n";
+    text += "root-" + std::to_string(i) + "\t1.0.0";
+    for (size_t j = 0; j < width; j++) {
+      text += "\tleaf-" + std::to_string(j) + "\t^1.0.0";
+    }
+    text += "\n";
+  }
+  auto packages = version_weaver::registry::parse(text).value();
+  std::vector<std::string> names;
+  for (size_t i = 0; i < width; i++) {
+    names.push_back("root-" + std::to_string(i));
+  }
+  std::vector<version_weaver::dependency> manifest;
+  for (const auto& name : names) {
+    manifest.push_back({name, "*"});
+  }
+  version_weaver::registry_source source(packages, 2ms);
+  version_weaver::executor pool(2);
+  auto result = version_weaver::sync_wait(
+      version_weaver::resolve_async(source, pool, manifest));
+  ASSERT_TRUE(result.has_value());
+  expect_same(*result, *version_weaver::resolve(packages, manifest));
+  ASSERT_EQ(result->packages.size(), 2 * width);
+  // Every package is fetched once, and the whole first layer at once.
+  ASSERT_EQ(source.fetch_count(), 2 * width);
+  ASSERT_GE(source.max_in_flight(), width);
+}
@@ -1,5 +1,11 @@
 #include "version_weaver.h"
+#include <array>
 #include <format>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <unordered_set>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -40,6 +46,10 @@ TEST(basictests, parse) {
     }
   }
 
+  static_assert(version_weaver::parse(" 1.2.3-rc.1+build ")->pre_release ==
+                "rc.1");
+  static_assert(version_weaver::parse("1.2").error() ==
+                version_weaver::parse_error::INVALID_INPUT);
   SUCCEED();
 }
 
@@ -96,9 +106,13 @@ std::vector<OrderingData> ordering_values = {
     {"1.0.0-alpha", "1.0.0-alpha.1", std::strong_ordering::less},
     {"1.0.0-alpha.1", "1.0.0-beta", std::strong_ordering::less},
     {"1.0.0-beta", "1.0.0-beta.2", std::strong_ordering::less},
-    {"1.0.0-beta.2", "1.0.0-beta.11", std::strong_ordering::greater},
+    {"1.0.0-beta.2", "1.0.0-beta.11", std::strong_ordering::less},
     {"1.0.0-beta.11", "1.0.0-rc.1", std::strong_ordering::less},
     {"1.0.0-rc.1", "1.0.0", std::strong_ordering::less},
+    {"1.0.0-alpha.1", "1.0.0-alpha.beta", std::strong_ordering::less},
+    {"1.0.0-1", "1.0.0-alpha", std::strong_ordering::less},
+    {"1.0.0-alpha-x", "1.0.0-alpha.1", std::strong_ordering::greater},
+    {"1.0.0-rc.1+build.2", "1.0.0-rc.1+build.1", std::strong_ordering::equal},
 };
 
 TEST(basictests, order) {
@@ -107,6 +121,87 @@ TEST(basictests, order) {
     auto v2 = version_weaver::parse(view2).value();
     ASSERT_EQ(v1 <=> v2, order);
   }
+  static_assert(version_weaver::parse("1.0.0-rc.1").value() <
+                version_weaver::parse("1.0.0").value());
+}
+
+TEST(basictests, compare) {
+  for (const auto& [view1, view2, order] : ordering_values) {
+    ASSERT_EQ(version_weaver::compare(view1, view2), order)
+        << view1 << " " << view2;
+    ASSERT_EQ(version_weaver::compare(view2, view1), 0 <=> order)
+        << view2 << " " << view1;
+  }
+  std::vector<OrderingData> strings = {
+      {"2", "2.0.0", std::strong_ordering::equal},
+      {"1.9", "1.10.0", std::strong_ordering::less},
+      {"1.2.3", "1.2", std::strong_ordering::greater},
+      {"01.2.3", "1.2.3", std::strong_ordering::equal},
+      {"0.0.0-0", "0.0.0", std::strong_ordering::less},
+      {"99999999999999999999999.0.0", "99999999999999999999998.9.9",
+       std::strong_ordering::greater},
+      {"1.0.0-alpha.99999999999999999999", "1.0.0-alpha.100",
+       std::strong_ordering::greater},
+      {"1.0.0+build", "1.0.0", std::strong_ordering::equal},
+  };
+  for (const auto& [view1, view2, order] : strings) {
+    ASSERT_EQ(version_weaver::compare(view1, view2), order)
+        << view1 << " " << view2;
+  }
+  static_assert(version_weaver::compare("1.2.3", "1.10.0") < 0);
+}
+
+using DiffData =
+    std::tuple<version_weaver::version, version_weaver::version,
+               std::optional<version_weaver::release_type>>;
+
+TEST(basictests, diff) {
+  using enum version_weaver::release_type;
+  // https://github.com/npm/node-semver/blob/main/test/functions/diff.js
+  // Built directly, since parse() rejects a major of 0.
+  std::vector<DiffData> values = {
+      {{"1", "2", "3"}, {"0", "2", "3"}, MAJOR},
+      {{"0", "2", "3"}, {"1", "2", "3"}, MAJOR},
+      {{"1", "4", "5"}, {"0", "2", "3"}, MAJOR},
+      {{"1", "2", "3"}, {"2", "0", "0", "pre"}, PRE_MAJOR},
+      {{"1", "2", "3"}, {"1", "3", "3"}, MINOR},
+      {{"1", "0", "1"}, {"1", "1", "0", "pre"}, PRE_MINOR},
+      {{"1", "2", "3"}, {"1", "2", "4"}, PATCH},
+      {{"1", "2", "3"}, {"1", "2", "4", "pre"}, PRE_PATCH},
+      {{"0", "0", "1"}, {"0", "0", "1", "pre"}, PATCH},
+      {{"0", "0", "1"}, {"0", "0", "1", "pre-2"}, PATCH},
+      {{"1", "1", "0"}, {"1", "1", "0", "pre"}, MINOR},
+      {{"1", "1", "0", "pre-1"}, {"1", "1", "0", "pre-2"}, PRE_RELEASE},
+      {{"1", "0", "0"}, {"1", "0", "0"}, std::nullopt},
+      {{"1", "0", "0", "1"}, {"1", "0", "0", "1"}, std::nullopt},
+      {{"0", "0", "2", "1"}, {"0", "0", "2"}, PATCH},
+      {{"0", "0", "2", "1"}, {"0", "0", "3"}, PATCH},
+      {{"0", "0", "2", "1"}, {"0", "1", "0"}, MINOR},
+      {{"0", "0", "2", "1"}, {"1", "0", "0"}, MAJOR},
+      {{"0", "1", "0", "1"}, {"0", "1", "0"}, MINOR},
+      {{"1", "0", "0", "1"}, {"1", "0", "0"}, MAJOR},
+      {{"1", "0", "0", "1"}, {"1", "1", "1"}, MAJOR},
+      {{"1", "0", "0", "1"}, {"2", "1", "1"}, MAJOR},
+      {{"1", "0", "1", "1"}, {"1", "0", "1"}, PATCH},
+      {{"0", "0", "0", "1"}, {"0", "0", "0"}, MAJOR},
+      {{"1", "0", "0", "1"}, {"2", "0", "0"}, MAJOR},
+      {{"1", "0", "0", "1"}, {"2", "0", "0", "1"}, PRE_MAJOR},
+      {{"1", "0", "0", "1"}, {"1", "1", "0", "1"}, PRE_MINOR},
+      {{"1", "0", "0", "1"}, {"1", "0", "1", "1"}, PRE_PATCH},
+      {{"1", "9", "0"}, {"1", "10", "0"}, MINOR},
+  };
+  for (const auto& [first, second, expected] : values) {
+    ASSERT_EQ(version_weaver::diff(first, second), expected)
+        << std::string(first) << " " << std::string(second);
+    ASSERT_EQ(version_weaver::diff(second, first), expected)
+        << std::string(second) << " " << std::string(first);
+  }
+  ASSERT_EQ(version_weaver::diff("1.7.2", "1.7.2+build").value(),
+            std::nullopt);
+  ASSERT_EQ(version_weaver::diff("1.2.3", "1.2").error(),
+            version_weaver::INVALID_INPUT);
+  static_assert(version_weaver::diff("1.2.3", "2.0.0-rc.1").value() ==
+                PRE_MAJOR);
 }
 
 using CoerceData = std::pair<std::string, std::optional<std::string>>;
@@ -171,7 +266,9 @@ std::vector<CoerceData> coerce_values = {
     {"42.6.7.9.3-alpha", "42.6.7"},
     {"v2", "2.0.0"},
     {"v3.4 replaces v3.3.1", "3.4.0"},
-    {"4.6.3.9.2-alpha2", "4.6.3"}};
+    {"4.6.3.9.2-alpha2", "4.6.3"},
+    {"007.010.0", "7.10.0"},
+    {"123456789012345678901234567890.1.2", "123456789012345678901234567890.1.2"}};
 
 TEST(basictests, coerce) {
   for (const auto& [input, expected] : coerce_values) {
@@ -184,6 +281,72 @@ TEST(basictests, coerce) {
   }
 }
 
+std::vector<CoerceData> coerce_rtl_values = {
+    {"1.2.3", "1.2.3"},
+    {"1.2.3.4", "2.3.4"},
+    {"1.2.3/4", "4.0.0"},
+    {"1.2.3/4.5", "4.5.0"},
+    {"1.2.3.4/5.6", "5.6.0"},
+    {"1.2.3.4.5.6", "4.5.6"},
+    {"v3.4 replaces v3.3.1", "3.3.1"},
+    {"1..2", "2.0.0"},
+    {"007.010.0 ", "7.10.0"},
+    {"no digits at all", std::nullopt},
+    {"", std::nullopt},
+};
+
+TEST(basictests, coerce_rtl) {
+  for (const auto& [input, expected] : coerce_rtl_values) {
+    ASSERT_EQ(version_weaver::coerce(input, {.rtl = true}), expected) << input;
+  }
+}
+
+TEST(basictests, coerce_all) {
+  using Record = std::tuple<size_t, size_t, std::string>;
+  auto records = [](std::string_view text,
+                    version_weaver::coerce_options options = {}) {
+    std::vector<version_weaver::coerced_version> found;
+    version_weaver::coerce_all(text, found, options);
+    std::vector<Record> result;
+    for (const auto& [offset, length, normalized] : found) {
+      result.emplace_back(offset, length, std::string(normalized));
+    }
+    return result;
+  };
+  ASSERT_EQ(records("node/v18.17.1 linux"),
+            (std::vector<Record>{{6, 7, "18.17.1"}}));
+  ASSERT_EQ(records("Chrome 120.0.6099.129"),
+            (std::vector<Record>{{7, 10, "120.0.6099"}, {18, 3, "129.0.0"}}));
+  ASSERT_EQ(records("Chrome 120.0.6099.129", {.rtl = true}),
+            (std::vector<Record>{{11, 10, "0.6099.129"}, {7, 3, "120.0.0"}}));
+  ASSERT_EQ(records("Mozilla/5.0 (X11; Linux x86_64) rv:0109.00"),
+            (std::vector<Record>{{8, 3, "5.0.0"},
+                                 {14, 2, "11.0.0"},
+                                 {25, 2, "86.0.0"},
+                                 {28, 2, "64.0.0"},
+                                 {35, 7, "109.0.0"}}));
+  ASSERT_TRUE(records("").empty());
+  ASSERT_TRUE(records("no versions in this long line of text").empty());
+
+  // Every record is what coerce() finds at its offset, in a buffer longer
+  // than the eight bytes skipped at a time.
+  std::string log;
+  for (int i = 0; i < 100; i++) {
+    log += "request " + std::to_string(i) + " served by api/v" +
+           std::to_string(i % 7) + "." + std::to_string(i * 13 % 100) +
+           "\n";
+  }
+  std::vector<version_weaver::coerced_version> found;
+  version_weaver::coerce_all(log, found);
+  ASSERT_EQ(found.size(), 200);
+  for (const auto& [offset, length, normalized] : found) {
+    auto text = std::string_view(log).substr(offset, length);
+    ASSERT_EQ(version_weaver::coerce(text), std::string(normalized));
+    ASSERT_GE(size_t(normalized.major.data() - log.data()), offset);
+  }
+  ASSERT_EQ(std::string(found[3].normalized), "1.13.0");
+}
+
 using IncTestData = std::tuple<
     version_weaver::version, std::string, version_weaver::release_type,
     std::string,
@@ -229,8 +392,71 @@ std::vector<IncTestData> inc_values = {
     {version_weaver::version{"1", "2", "3", "alpha.0.beta"},
      "1.2.3-alpha.0.beta", version_weaver::release_type::PATCH, "1.2.3",
      version_weaver::version{"1", "2", "3"}},
+    {version_weaver::version{"2147483647", "2", "3"}, "2147483647.2.3",
+     version_weaver::release_type::MAJOR, "2147483648.0.0",
+     version_weaver::version{"2147483648", "0", "0"}},
+    {version_weaver::version{"1", "18446744073709551615", "3"},
+     "1.18446744073709551615.3", version_weaver::release_type::MINOR,
+     "1.18446744073709551616.0",
+     version_weaver::version{"1", "18446744073709551616", "0"}},
+    {version_weaver::version{"1", "2", "99999999999999999999999999"},
+     "1.2.99999999999999999999999999", version_weaver::release_type::PATCH,
+     "1.2.100000000000000000000000000",
+     version_weaver::version{"1", "2", "100000000000000000000000000"}},
+};
+
+TEST(basictests, increment_component) {
+  using version_weaver::decrement_component;
+  using version_weaver::increment_component;
+  static_assert(increment_component("41")->view() == "42");
+  static_assert(decrement_component("1000")->view() == "999");
+
+  std::vector<std::pair<std::string_view, std::string_view>> values = {
+      {"0", "1"},
+      {"9", "10"},
+      {"0099", "100"},
+      {"18446744073709551614", "18446744073709551615"},
+      {"18446744073709551615", "18446744073709551616"},
+      {"99999999999999999999", "100000000000000000000"},
+      {"123456789012345678901234567890", "123456789012345678901234567891"},
+  };
+  for (const auto& [input, expected] : values) {
+    auto incremented = increment_component(input);
+    ASSERT_TRUE(incremented.has_value()) << input;
+    ASSERT_EQ(incremented->view(), expected);
+    auto decremented = decrement_component(expected);
+    ASSERT_TRUE(decremented.has_value()) << expected;
+    ASSERT_EQ(decremented->view(), version_weaver::trim_leading_zeroes(input));
+  }
+
+  ASSERT_FALSE(decrement_component("0").has_value());
+  ASSERT_FALSE(decrement_component("000").has_value());
+  ASSERT_FALSE(increment_component("").has_value());
+  ASSERT_FALSE(increment_component("1a").has_value());
+  ASSERT_FALSE(
+      increment_component("123456789012345678901234567890x").has_value());
+  ASSERT_FALSE(decrement_component("-1").has_value());
+}
+
+std::vector<CoerceData> increment_version_values = {
+    {"1.2.3", "1.2.4"},
+    {"1.2", "1.2.1"},
+    {"1.02.3-rc", "1.2.3-rc.0"},
+    {"1.2.3+build", "1.2.4"},
+    {"1.2.3-beta+build-5", "1.2.3-beta.0"},
+    {" 1.2.3", "1.2.4"},
+    {"1.2.3\n", "1.2.4"},
+    {"1.2.18446744073709551615", "1.2.18446744073709551616"},
+    {"v1.2.3", std::nullopt},
+    {"1.x.3", std::nullopt},
 };
 
+TEST(basictests, increment_version) {
+  for (const auto& [input, expected] : increment_version_values) {
+    ASSERT_EQ(version_weaver::incrementVersion(input), expected) << input;
+  }
+}
+
 TEST(basictests, inc) {
   for (const auto& [input, inputstr, release_type, str, expected] :
        inc_values) {
@@ -253,6 +479,104 @@ TEST(basictests, inc) {
   SUCCEED();
 }
 
+using PreReleaseTestData =
+    std::tuple<std::string_view, version_weaver::release_type, std::string_view,
+               version_weaver::identifier_base,
+               std::expected<std::string_view, version_weaver::parse_error>>;
+
+// https://github.com/npm/node-semver/blob/main/test/fixtures/increments.js
+std::vector<PreReleaseTestData> pre_release_inc_values = {
+    {"1.2.3-4", version_weaver::PRE_RELEASE, "", version_weaver::BASE_ZERO,
+     "1.2.3-5"},
+    {"1.2.3-alpha.0.beta", version_weaver::PRE_RELEASE, "",
+     version_weaver::BASE_ZERO, "1.2.3-alpha.1.beta"},
+    {"1.2.3-alpha.10.0.beta", version_weaver::PRE_RELEASE, "",
+     version_weaver::BASE_ZERO, "1.2.3-alpha.10.1.beta"},
+    {"1.2.3-alpha.9.beta", version_weaver::PRE_RELEASE, "",
+     version_weaver::BASE_ZERO, "1.2.3-alpha.10.beta"},
+    {"1.2.3-alpha.beta", version_weaver::PRE_RELEASE, "",
+     version_weaver::BASE_ZERO, "1.2.3-alpha.beta.0"},
+    {"1.2.3", version_weaver::PRE_RELEASE, "", version_weaver::BASE_ZERO,
+     "1.2.4-0"},
+    {"1.2.0", version_weaver::PRE_PATCH, "", version_weaver::BASE_ZERO,
+     "1.2.1-0"},
+    {"1.2.0-1", version_weaver::PRE_PATCH, "", version_weaver::BASE_ZERO,
+     "1.2.1-0"},
+    {"1.2.3-1", version_weaver::PRE_MINOR, "", version_weaver::BASE_ZERO,
+     "1.3.0-0"},
+    {"1.2.3-1", version_weaver::PRE_MAJOR, "", version_weaver::BASE_ZERO,
+     "2.0.0-0"},
+    {"1.2.0-1", version_weaver::MINOR, "", version_weaver::BASE_ZERO, "1.2.0"},
+    {"1.0.0-1", version_weaver::MAJOR, "", version_weaver::BASE_ZERO, "1.0.0"},
+    {"1.2.3+build", version_weaver::PATCH, "", version_weaver::BASE_ZERO,
+     "1.2.4"},
+    {"1.2.3", version_weaver::MAJOR, "dev", version_weaver::BASE_ZERO,
+     "2.0.0"},
+    {"1.2.3", version_weaver::PRE_RELEASE, "dev", version_weaver::BASE_ZERO,
+     "1.2.4-dev.0"},
+    {"1.2.3-dev.1", version_weaver::PRE_RELEASE, "dev",
+     version_weaver::BASE_ZERO, "1.2.3-dev.2"},
+    {"1.2.3-alpha.0", version_weaver::PRE_RELEASE, "dev",
+     version_weaver::BASE_ZERO, "1.2.3-dev.0"},
+    {"1.2.3-alpha.beta", version_weaver::PRE_RELEASE, "alpha",
+     version_weaver::BASE_ZERO, "1.2.3-alpha.0"},
+    {"1.2.0-1", version_weaver::PRE_PATCH, "dev", version_weaver::BASE_ZERO,
+     "1.2.1-dev.0"},
+    {"1.2.0", version_weaver::PRE_MINOR, "dev", version_weaver::BASE_ZERO,
+     "1.3.0-dev.0"},
+    {"1.2.0", version_weaver::PRE_MAJOR, "dev.rc", version_weaver::BASE_ZERO,
+     "2.0.0-dev.rc.0"},
+    {"1.2.0", version_weaver::PRE_RELEASE, "alpha", version_weaver::BASE_ONE,
+     "1.2.1-alpha.1"},
+    {"1.2.0", version_weaver::PRE_RELEASE, "", version_weaver::BASE_ONE,
+     "1.2.1-1"},
+    {"1.2.0", version_weaver::PRE_RELEASE, "alpha", version_weaver::BASE_NONE,
+     "1.2.1-alpha"},
+    {"1.2.3-alpha.1", version_weaver::PRE_RELEASE, "alpha",
+     version_weaver::BASE_NONE, "1.2.3-alpha.2"},
+    {"1.2.3-alpha", version_weaver::PRE_RELEASE, "alpha",
+     version_weaver::BASE_NONE,
+     std::unexpected(version_weaver::parse_error::INVALID_IDENTIFIER)},
+    {"1.2.3", version_weaver::PRE_RELEASE, "", version_weaver::BASE_NONE,
+     std::unexpected(version_weaver::parse_error::INVALID_IDENTIFIER)},
+    {"1.2.3", version_weaver::PRE_MINOR, "a..b", version_weaver::BASE_ZERO,
+     std::unexpected(version_weaver::parse_error::INVALID_IDENTIFIER)},
+    {"1.2.3", version_weaver::PRE_MINOR, "01", version_weaver::BASE_ZERO,
+     std::unexpected(version_weaver::parse_error::INVALID_IDENTIFIER)},
+    {"1.2.0-beta.1+build", version_weaver::RELEASE, "",
+     version_weaver::BASE_ZERO, "1.2.0"},
+    {"1.2.0", version_weaver::RELEASE, "", version_weaver::BASE_ZERO,
+     std::unexpected(version_weaver::parse_error::INVALID_RELEASE_TYPE)},
+};
+
+TEST(basictests, inc_pre_release) {
+  version_weaver::version_buffer output;
+  for (const auto& [input, release_type, identifier, base, expected] :
+       pre_release_inc_values) {
+    auto parsed = version_weaver::parse(input);
+    ASSERT_TRUE(parsed.has_value()) << input;
+    auto result =
+        version_weaver::inc(*parsed, release_type, output, identifier, base);
+    ASSERT_EQ(result.has_value(), expected.has_value()) << input;
+    if (result.has_value()) {
+      ASSERT_EQ(*result, *expected) << input;
+      ASSERT_EQ(version_weaver::increment(input, release_type, identifier,
+                                          base),
+                std::string(*expected));
+    } else {
+      ASSERT_EQ(result.error(), expected.error()) << input;
+    }
+  }
+
+  std::string longest(version_weaver::MAX_VERSION_LENGTH - 4, '9');
+  longest += ".0.0";
+  auto parsed = version_weaver::parse(longest);
+  ASSERT_TRUE(parsed.has_value());
+  ASSERT_EQ(version_weaver::inc(*parsed, version_weaver::PRE_MAJOR, output)
+                .error(),
+            version_weaver::parse_error::VERSION_LARGER_THAN_MAX_LENGTH);
+}
+
 TEST(basictests, plus) {
   for (const auto& [input, inputstr, release_type, str, expected] :
        inc_values) {
@@ -301,6 +625,10 @@ std::vector<MinimumData> min_version_value = {
     // // '-' operator
     {"1.1.1 - 1.8.0", "1.1.1"},
     {"1.1 - 1.8.0", "1.1.0"},
+    {"1.2.3-pre - 2", "1.2.3-pre"},
+    {"* - 2", "0.0.0"},
+    {"1.x - 2.x", "1.0.0"},
+    {"3.0.0 - 2.0.0", std::nullopt},
 
     // // Less / less or equal
     {"<2", "0.0.0"},
@@ -342,3 +670,325 @@ TEST(basictests, minimum) {
     }
   }
 }
+
+std::vector<std::string> sort_values = {
+    "1.0.0-rc.1", "2.0.0",         "1.0.0",     "1.0.0-alpha", "1.10.0",
+    "1.2.0",      "1.0.0-beta.11", "1.0.0+001", "3.1.0",       "1.0.0-beta",
+    "10.0.0",     "1.0.0-alpha.1", "1.9.9",     "2.0.0-0",     "1.0.0-beta",
+};
+
+void expect_sorted(std::span<version_weaver::version> versions,
+                   std::span<version_weaver::version> reference) {
+  std::stable_sort(reference.begin(), reference.end(),
+                   [](const auto& a, const auto& b) { return a < b; });
+  ASSERT_EQ(versions.size(), reference.size());
+  for (size_t i = 0; i < versions.size(); i++) {
+    ASSERT_EQ(std::string(versions[i]), std::string(reference[i]));
+  }
+}
+
+TEST(basictests, sort_versions) {
+  std::vector<version_weaver::version> versions;
+  for (const auto& v : sort_values) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  auto reference = versions;
+  version_weaver::sort_versions(versions);
+  expect_sorted(versions, reference);
+
+  // Components too wide for a packed key take the comparison-based path.
+  versions.push_back(
+      version_weaver::parse("1.99999999999999999999999.0").value());
+  reference = versions;
+  version_weaver::sort_versions(versions);
+  expect_sorted(versions, reference);
+}
+
+TEST(basictests, sort_versions_parallel) {
+  std::vector<std::string> inputs;
+  for (size_t i = 0; i < version_weaver::PARALLEL_SORT_THRESHOLD * 2; i++) {
+    size_t x = (i * 2654435761u) % 1000003;
+    inputs.push_back(std::format("{}.{}.{}", 1 + x % 7, x % 13, x % 101) +
+                     (x % 5 == 0 ? "-beta." + std::to_string(x % 3) : ""));
+  }
+  std::vector<version_weaver::version> versions;
+  for (const auto& v : inputs) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  auto reference = versions;
+  version_weaver::sort_versions(versions, 4);
+  expect_sorted(versions, reference);
+}
+
+TEST(basictests, unique_versions) {
+  std::vector<version_weaver::version> versions;
+  for (const auto& v : sort_values) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  version_weaver::sort_versions(versions);
+  size_t kept = version_weaver::unique_versions(versions);
+  // "1.0.0+001" has the precedence of "1.0.0", and "1.0.0-beta" is repeated.
+  ASSERT_EQ(kept, sort_values.size() - 2);
+  for (size_t i = 1; i < kept; i++) {
+    ASSERT_TRUE(versions[i - 1] < versions[i]);
+  }
+}
+
+TEST(basictests, release_lines) {
+  std::vector<std::string> text = {
+      "1.0.0",      "1.0.1",     "1.2.0",     "1.2.1-rc.1", "2.0.0-rc.1",
+      "2.0.0",      "2.1.0-rc.1", "3.0.0-a.1", "3.0.0-a.2", "10.0.0",
+      "10.1.0",     "10.1.1-rc.1", "10.1.1"};
+  std::vector<version_weaver::version> versions;
+  for (const auto& v : text) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  auto latest = [&](const version_weaver::release_line& line) {
+    return text[line.latest];
+  };
+
+  auto majors =
+      version_weaver::release_lines(versions, version_weaver::MAJOR_LINE);
+  ASSERT_EQ(majors.size(), 4);
+  ASSERT_EQ(majors[0].begin, 0);
+  ASSERT_EQ(majors[0].end, 4);
+  ASSERT_EQ(latest(majors[0]), "1.2.0");
+  ASSERT_EQ(latest(majors[1]), "2.0.0");
+  // A line of pre-releases only has its highest pre-release as the latest.
+  ASSERT_EQ(latest(majors[2]), "3.0.0-a.2");
+  ASSERT_EQ(majors[3].begin, 9);
+  ASSERT_EQ(majors[3].end, 13);
+  ASSERT_EQ(latest(majors[3]), "10.1.1");
+
+  auto minors =
+      version_weaver::release_lines(versions, version_weaver::MINOR_LINE);
+  std::vector<std::string> latest_minors;
+  for (const auto& line : minors) {
+    latest_minors.push_back(latest(line));
+  }
+  ASSERT_EQ(latest_minors,
+            (std::vector<std::string>{"1.0.1", "1.2.0", "2.0.0", "2.1.0-rc.1",
+                                      "3.0.0-a.2", "10.0.0", "10.1.1"}));
+  ASSERT_TRUE(
+      version_weaver::release_lines({}, version_weaver::MAJOR_LINE).empty());
+
+  auto line = version_weaver::find_release_line(versions, "10");
+  ASSERT_TRUE(line.has_value());
+  ASSERT_EQ(line->begin, 9);
+  ASSERT_EQ(latest(*line), "10.1.1");
+  line = version_weaver::find_release_line(versions, "1", "2");
+  ASSERT_TRUE(line.has_value());
+  ASSERT_EQ(line->begin, 2);
+  ASSERT_EQ(line->end, 4);
+  ASSERT_EQ(latest(*line), "1.2.0");
+  ASSERT_FALSE(version_weaver::find_release_line(versions, "4").has_value());
+  ASSERT_FALSE(
+      version_weaver::find_release_line(versions, "1", "1").has_value());
+
+  // Long lines, whose ends are found by galloping.
+  versions.clear();
+  std::vector<std::string> many;
+  for (size_t major = 1; major <= 3; major++) {
+    for (size_t patch = 0; patch < 1000; patch++) {
+      many.push_back(std::to_string(major) + "." + std::to_string(major * 7) +
+                     "." + std::to_string(patch));
+    }
+  }
+  for (const auto& v : many) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  majors = version_weaver::release_lines(versions, version_weaver::MAJOR_LINE);
+  ASSERT_EQ(majors.size(), 3);
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_EQ(majors[i].begin, i * 1000);
+    ASSERT_EQ(majors[i].end, (i + 1) * 1000);
+    ASSERT_EQ(majors[i].latest, (i + 1) * 1000 - 1);
+  }
+}
+
+TEST(basictests, pre_release_table) {
+  std::vector<std::optional<std::string_view>> pre_releases = {
+      "rc.1",        "alpha",        "beta.11",       std::nullopt,
+      "beta.2",      "alpha.1",      "alpha.beta",    "1",
+      "99999999999", "2147483648",   "2147483647",    "beta",
+      "canary.3f2a", "canary.3f2a.1", "rc.1.0",       "0",
+      "alpha-2",     "Alpha",        "next.20240101", "rc.1",
+  };
+  version_weaver::pre_release_table table;
+  std::vector<version_weaver::pre_release_table::id> ids;
+  for (size_t i = 0; i < pre_releases.size(); i++) {
+    ids.push_back(table.intern(pre_releases[i]));
+    // Ranks stay consistent while identifiers are added.
+    for (size_t j = 0; j <= i; j++) {
+      ASSERT_EQ(table.compare(ids[i], ids[j]),
+                version_weaver::compare_pre_release(pre_releases[i],
+                                                    pre_releases[j]))
+          << pre_releases[i].value_or("") << " "
+          << pre_releases[j].value_or("");
+      ASSERT_EQ(table.compare(ids[j], ids[i]),
+                version_weaver::compare_pre_release(pre_releases[j],
+                                                    pre_releases[i]));
+    }
+  }
+  // "rc.1" is interned once.
+  ASSERT_EQ(ids[0].offset, ids[19].offset);
+  ASSERT_EQ(table.symbol_count(), 10);
+
+  auto a = version_weaver::parse("1.2.3-beta.2").value();
+  auto b = version_weaver::parse("1.2.3-beta.11").value();
+  auto c = version_weaver::parse("1.10.0-alpha").value();
+  auto a_id = table.intern(a.pre_release);
+  auto b_id = table.intern(b.pre_release);
+  auto c_id = table.intern(c.pre_release);
+  ASSERT_EQ(table.compare(a, a_id, b, b_id), std::strong_ordering::less);
+  ASSERT_EQ(table.compare(c, c_id, b, b_id), std::strong_ordering::greater);
+  ASSERT_EQ(table.compare(b, b_id, b, b_id), std::strong_ordering::equal);
+}
+
+TEST(basictests, pre_release_table_many_symbols) {
+  // Commit hashes make nearly every identifier new.
+  std::mt19937_64 rng(42);
+  std::vector<std::string> hashes;
+  for (size_t i = 0; i < 5000; i++) {
+    hashes.push_back(std::format("g{:07x}", rng() & 0xfffffff));
+  }
+  version_weaver::pre_release_table table;
+  std::vector<version_weaver::pre_release_table::id> ids;
+  for (size_t i = 0; i < hashes.size(); i++) {
+    ids.push_back(table.intern("dev." + hashes[i]));
+    // Compare with a few earlier ones while the table grows, whether they
+    // were ranked yet or not.
+    for (size_t j : {size_t(0), i / 2, i - std::min<size_t>(i, 3)}) {
+      ASSERT_EQ(table.compare(ids[i], ids[j]),
+                version_weaver::compare_identifiers(hashes[i], hashes[j]))
+          << hashes[i] << " " << hashes[j];
+    }
+  }
+  ASSERT_EQ(table.symbol_count(),
+            std::unordered_set<std::string>(hashes.begin(), hashes.end())
+                    .size() +
+                1);
+  std::vector<size_t> order(hashes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::ranges::sort(order, [&](size_t a, size_t b) {
+    return table.compare(ids[a], ids[b]) < 0;
+  });
+  for (size_t i = 1; i < order.size(); i++) {
+    ASSERT_LE(hashes[order[i - 1]], hashes[order[i]]);
+  }
+}
+
+TEST(basictests, hash) {
+  auto plain = version_weaver::parse("1.2.3-beta.1").value();
+  auto built = version_weaver::parse("1.2.3-beta.1+exp.sha.5114f85").value();
+  auto other = version_weaver::parse("1.2.3-beta.2").value();
+  ASSERT_TRUE(plain == built);
+  ASSERT_FALSE(plain == other);
+  ASSERT_FALSE(version_weaver::identical(plain, built));
+  ASSERT_EQ(version_weaver::precedence_hash(plain),
+            version_weaver::precedence_hash(built));
+  ASSERT_NE(version_weaver::identity_hash(plain),
+            version_weaver::identity_hash(built));
+  ASSERT_NE(version_weaver::precedence_hash(plain),
+            version_weaver::precedence_hash(other));
+  // Field boundaries matter: 1.23.4 and 12.3.4 must not collide.
+  ASSERT_NE(version_weaver::precedence_hash(
+                version_weaver::parse("1.23.4").value()),
+            version_weaver::precedence_hash(
+                version_weaver::parse("12.3.4").value()));
+  static_assert(version_weaver::precedence_hash({"1", "2", "3"}) ==
+                version_weaver::precedence_hash({"1", "2", "3", {}, "b"}));
+
+  std::unordered_set<version_weaver::version> by_precedence{plain, built,
+                                                            other};
+  ASSERT_EQ(by_precedence.size(), 2);
+  std::unordered_set<version_weaver::version,
+                     version_weaver::version_identity_hash,
+                     version_weaver::version_identity_equal>
+      by_identity{plain, built, other};
+  ASSERT_EQ(by_identity.size(), 3);
+}
+
+TEST(basictests, lazy_version) {
+  for (const auto& [input, expected] : parse_values) {
+    auto result = version_weaver::lazy_version(input).to_version();
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->major, expected->major);
+    ASSERT_EQ(result->minor, expected->minor);
+    ASSERT_EQ(result->patch, expected->patch);
+    ASSERT_EQ(result->pre_release, expected->pre_release);
+    ASSERT_EQ(result->build, expected->build);
+  }
+  for (std::string_view invalid :
+       {"0.0.0", "01.0.0", "1.01.0", "1.0.01", "1.0", "1.0.0-", "1.0.0+",
+        "1.0.0-beta+", "1.0.0x", "a.b.c"}) {
+    ASSERT_EQ(version_weaver::lazy_version(invalid).to_version().has_value(),
+              version_weaver::parse(invalid).has_value())
+        << invalid;
+  }
+
+  for (const auto& [view1, view2, order] : ordering_values) {
+    version_weaver::lazy_version v1(view1);
+    version_weaver::lazy_version v2(view2);
+    ASSERT_EQ(v1 <=> v2, order) << view1 << " " << view2;
+    ASSERT_EQ(v1 <=> version_weaver::parse(view2).value(), order);
+  }
+
+  // Decided by the major version: nothing past the first dot is decoded,
+  // not even the invalid tail.
+  version_weaver::lazy_version lower("1.2.3");
+  version_weaver::lazy_version higher("2.0.invalid");
+  ASSERT_TRUE(lower < higher);
+  ASSERT_EQ(lower.decoded(), 1);
+  ASSERT_EQ(higher.decoded(), 1);
+  ASSERT_FALSE(higher.patch().has_value());
+  ASSERT_FALSE(lower == higher);
+  ASSERT_TRUE(version_weaver::lazy_version("1.2.3+a") ==
+              version_weaver::lazy_version("1.2.3+b"));
+  // Once an invalid part has to be looked at, the versions are unordered.
+  auto unordered = version_weaver::lazy_version("1.2.x") <=>
+                   version_weaver::lazy_version("1.2.3");
+  ASSERT_EQ(unordered, std::partial_ordering::unordered);
+
+}
+
+TEST(basictests, memory_resource) {
+  // Nothing may come from the default resource while the results are built.
+  std::pmr::memory_resource* previous =
+      std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  std::array<std::byte, 4096> buffer;
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(),
+                                            std::pmr::null_memory_resource());
+  auto v = version_weaver::parse("1.2.3-beta.4").value();
+  std::pmr::string text = v.to_string(&arena);
+  auto coerced = version_weaver::coerce("v18.17", {}, &arena);
+  auto next = version_weaver::inc(v, version_weaver::PRE_RELEASE, &arena);
+  auto lowest = version_weaver::minimum(">1.2.3-alpha <2", &arena);
+  auto incremented = version_weaver::incrementVersion("1.02.3-rc", &arena);
+  auto decremented = version_weaver::decrementVersion("0.4.1", &arena);
+  std::pmr::set_default_resource(previous);
+
+  ASSERT_EQ(text, "1.2.3-beta.4");
+  ASSERT_EQ(text.get_allocator().resource(), &arena);
+  ASSERT_EQ(coerced, "18.17.0");
+  ASSERT_EQ(coerced->get_allocator().resource(), &arena);
+  ASSERT_EQ(next, "1.2.3-beta.5");
+  ASSERT_EQ(lowest, "1.2.3-alpha.0");
+  ASSERT_EQ(incremented, "1.2.3-rc.0");
+  ASSERT_EQ(incremented->get_allocator().resource(), &arena);
+  ASSERT_EQ(decremented, "0.5.0");
+  for (std::string_view input :
+       {"1.2.3", "v1", "1.2", "1.2.3-beta.1", "0.0.7", "1-alpha", "x"}) {
+    auto expected = version_weaver::incrementVersion(input);
+    auto result = version_weaver::incrementVersion(input, &arena);
+    ASSERT_EQ(result.has_value(), expected.has_value()) << input;
+    ASSERT_EQ(std::string_view(result.value_or("")), expected.value_or(""))
+        << input;
+    expected = version_weaver::decrementVersion(input);
+    result = version_weaver::decrementVersion(input, &arena);
+    ASSERT_EQ(result.has_value(), expected.has_value()) << input;
+    ASSERT_EQ(std::string_view(result.value_or("")), expected.value_or(""))
+        << input;
+  }
+  ASSERT_EQ(version_weaver::coerce("none", {}, &arena), std::nullopt);
+}
@@ -0,0 +1,124 @@
+#include "version_weaver/catalog.h"
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+version_weaver::catalog_writer make_writer() {
+  version_weaver::catalog_writer writer;
+  std::vector<std::string_view> left_pad = {"1.3.0", "1.0.0", "1.1.0-beta.1",
+                                            "1.1.0", "1.2.0+build.7"};
+  std::vector<std::string_view> express = {"4.18.2", "5.0.0-beta.1", "3.21.2",
+                                           "99999999999999999999999.0.0"};
+  EXPECT_TRUE(writer.add("left-pad", left_pad));
+  EXPECT_TRUE(writer.add("express", express));
+  std::vector<std::string_view> more = {"1.0.1"};
+  EXPECT_TRUE(writer.add("left-pad", more));
+  return writer;
+}
+
+TEST(catalogtests, roundtrip) {
+  auto bytes = make_writer().finish();
+  auto catalog = version_weaver::catalog_view::open(bytes);
+  ASSERT_TRUE(catalog.has_value());
+  ASSERT_TRUE(catalog->validate().has_value());
+  ASSERT_EQ(catalog->package_count(), 2);
+  ASSERT_EQ(catalog->version_count(), 10);
+  ASSERT_EQ(catalog->package(0).name(), "express");
+  ASSERT_FALSE(catalog->find("react").has_value());
+
+  auto left_pad = catalog->find("left-pad");
+  ASSERT_TRUE(left_pad.has_value());
+  std::vector<std::string> expected = {"1.0.0",        "1.0.1", "1.1.0-beta.1",
+                                       "1.1.0",        "1.2.0+build.7",
+                                       "1.3.0"};
+  ASSERT_EQ(left_pad->size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(std::string((*left_pad)[i]), expected[i]);
+  }
+  ASSERT_EQ((*left_pad)[2].pre_release, "beta.1");
+  ASSERT_EQ((*left_pad)[4].build, "build.7");
+  ASSERT_EQ(left_pad->minors()[5], 3);
+
+  auto express = catalog->find("express");
+  ASSERT_TRUE(express.has_value());
+  ASSERT_EQ(express->size(), 4);
+  ASSERT_EQ(std::string((*express)[3]), "99999999999999999999999.0.0");
+  ASSERT_EQ(express->majors()[3], UINT64_MAX);
+}
+
+TEST(catalogtests, rejects_damage) {
+  auto bytes = make_writer().finish();
+  auto truncated = std::span(bytes).first(bytes.size() / 2);
+  ASSERT_EQ(version_weaver::catalog_view::open(truncated).error(),
+            version_weaver::CATALOG_TRUNCATED);
+
+  auto bad_magic = bytes;
+  bad_magic[0] = std::byte{'X'};
+  ASSERT_EQ(version_weaver::catalog_view::open(bad_magic).error(),
+            version_weaver::CATALOG_BAD_MAGIC);
+
+  auto flipped = bytes;
+  flipped[flipped.size() - 9] ^= std::byte{1};
+  auto catalog = version_weaver::catalog_view::open(flipped);
+  ASSERT_TRUE(catalog.has_value());
+  ASSERT_EQ(catalog->validate().error(),
+            version_weaver::CATALOG_CHECKSUM_MISMATCH);
+
+  version_weaver::catalog_writer writer;
+  std::vector<std::string_view> invalid = {"1.0.0", "not-a-version"};
+  ASSERT_EQ(writer.add("broken", invalid).error(),
+            version_weaver::CATALOG_INVALID_VERSION);
+}
+
+TEST(catalogtests, lookups_stay_in_bounds) {
+  // Damage that open() accepts and only validate() reports.
+  auto bytes = make_writer().finish();
+  version_weaver::catalog_header header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  version_weaver::catalog_package entry;
+  std::memcpy(&entry, bytes.data() + header.directory_offset, sizeof(entry));
+  entry.name_length = UINT64_MAX;
+  entry.version_count = UINT64_MAX;
+  std::memcpy(bytes.data() + header.directory_offset, &entry, sizeof(entry));
+  version_weaver::catalog_record record;
+  std::memcpy(&record, bytes.data() + header.records_offset, sizeof(record));
+  record.text_offset = UINT64_MAX - 1;
+  std::memcpy(bytes.data() + header.records_offset, &record, sizeof(record));
+  std::memcpy(&record, bytes.data() + header.records_offset + sizeof(record),
+              sizeof(record));
+  record.major_length = UINT16_MAX;
+  record.flags |= version_weaver::CATALOG_RECORD_BUILD;
+  std::memcpy(bytes.data() + header.records_offset + sizeof(record), &record,
+              sizeof(record));
+
+  auto catalog = version_weaver::catalog_view::open(bytes);
+  ASSERT_TRUE(catalog.has_value());
+  ASSERT_FALSE(catalog->validate().has_value());
+  auto first = catalog->package(0);
+  ASSERT_EQ(first.size(), catalog->version_count());
+  ASSERT_TRUE(first.name().starts_with("express"));
+  ASSERT_EQ(std::string(first[0]), "..");
+  ASSERT_EQ(first[1].major.size(), record.text_length);
+  ASSERT_FALSE(catalog->find("express").has_value());
+  ASSERT_TRUE(catalog->find("left-pad").has_value());
+}
+
+TEST(catalogtests, mapped_file) {
+  auto path =
+      (std::filesystem::temp_directory_path() / "version_weaver_catalog.bin")
+          .string();
+  ASSERT_TRUE(make_writer().write(path).has_value());
+  {
+    auto file = version_weaver::mapped_file::open(path);
+    ASSERT_TRUE(file.has_value());
+    auto catalog = version_weaver::catalog_view::open(file->bytes());
+    ASSERT_TRUE(catalog.has_value());
+    ASSERT_TRUE(catalog->validate().has_value());
+    ASSERT_EQ(std::string((*catalog->find("left-pad"))[0]), "1.0.0");
+  }
+  std::filesystem::remove(path);
+  ASSERT_EQ(version_weaver::mapped_file::open(path).error(),
+            version_weaver::CATALOG_IO_ERROR);
+}
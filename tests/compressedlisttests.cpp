@@ -0,0 +1,86 @@
+#include "version_weaver/compressed_list.h"
+#include <format>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Every version of a package with a release history of a few thousand
+// entries, including pre-releases and build metadata.
+std::vector<std::string> make_history() {
+  std::vector<std::string> history;
+  for (int major = 1; major <= 4; major++) {
+    for (int minor = 0; minor < 25; minor++) {
+      for (int patch = 0; patch < 30; patch++) {
+        if (patch == 0) {
+          history.push_back(std::format("{}.{}.0-rc.1", major, minor));
+        }
+        history.push_back(std::format("{}.{}.{}", major, minor, patch) +
+                          (patch % 7 == 3 ? "+build.1" : ""));
+      }
+    }
+  }
+  return history;
+}
+
+std::vector<version_weaver::version> parse_all(
+    const std::vector<std::string>& text) {
+  std::vector<version_weaver::version> versions;
+  for (const auto& v : text) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  return versions;
+}
+
+TEST(compressedlisttests, roundtrip) {
+  auto history = make_history();
+  auto versions = parse_all(history);
+  auto list = version_weaver::compressed_version_list::encode(versions);
+  ASSERT_TRUE(list.has_value());
+  ASSERT_EQ(list->size(), history.size());
+  auto decoded = list->decode();
+  ASSERT_EQ(decoded.size(), history.size());
+  for (size_t i = 0; i < history.size(); i++) {
+    ASSERT_EQ(std::string(decoded[i]), history[i]);
+    ASSERT_EQ(std::string((*list)[i]), history[i]);
+  }
+  // Mostly patch bumps: about three bytes per version.
+  ASSERT_LT(list->byte_size(), history.size() * 4);
+}
+
+TEST(compressedlisttests, bounds) {
+  auto history = make_history();
+  auto versions = parse_all(history);
+  auto list = version_weaver::compressed_version_list::encode(versions);
+  ASSERT_TRUE(list.has_value());
+  std::vector<std::string> probes = {"1.0.0-alpha", "1.0.0-rc.1", "1.0.0",
+                                     "2.13.3",      "2.13.3+other", "3.5.0-rc.2",
+                                     "3.24.29",     "4.24.29",    "5.0.0",
+                                     "1.2.99"};
+  for (const auto& text : probes) {
+    auto probe = version_weaver::parse(text).value();
+    auto lower = std::lower_bound(
+        versions.begin(), versions.end(), probe,
+        [](const auto& a, const auto& b) { return a < b; });
+    auto upper = std::upper_bound(
+        versions.begin(), versions.end(), probe,
+        [](const auto& a, const auto& b) { return a < b; });
+    ASSERT_EQ(list->lower_bound(probe), size_t(lower - versions.begin()))
+        << text;
+    ASSERT_EQ(list->upper_bound(probe), size_t(upper - versions.begin()))
+        << text;
+  }
+  // The highest 2.x is the entry just before the first 3.0.0 pre-release.
+  size_t end = list->lower_bound(version_weaver::parse("3.0.0-0").value());
+  ASSERT_EQ(std::string((*list)[end - 1]), "2.24.29");
+}
+
+TEST(compressedlisttests, rejects) {
+  std::vector<std::string> unsorted_text = {"1.0.1", "1.0.0"};
+  auto unsorted = parse_all(unsorted_text);
+  ASSERT_EQ(version_weaver::compressed_version_list::encode(unsorted).error(),
+            version_weaver::parse_error::INVALID_INPUT);
+  std::vector<std::string> wide_text = {"1.99999999999999999999.0"};
+  auto wide = parse_all(wide_text);
+  ASSERT_EQ(version_weaver::compressed_version_list::encode(wide).error(),
+            version_weaver::parse_error::INVALID_MINOR);
+}
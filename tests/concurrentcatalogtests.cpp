@@ -0,0 +1,155 @@
+#include "version_weaver/concurrent_catalog.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+std::vector<version_weaver::version> parse_all(
+    const std::vector<std::string>& text) {
+  std::vector<version_weaver::version> versions;
+  for (const auto& v : text) {
+    versions.push_back(version_weaver::parse(v).value());
+  }
+  return versions;
+}
+
+// Versions 1.0.0 to 1.(count - 1).0 of generation `major`, in reverse order.
+std::vector<std::string> make_generation(size_t major, size_t count) {
+  std::vector<std::string> text;
+  for (size_t i = count; i-- > 0;) {
+    text.push_back(std::to_string(major) + "." + std::to_string(i) + ".0");
+  }
+  return text;
+}
+
+TEST(concurrentcatalogtests, publish) {
+  version_weaver::concurrent_catalog catalog;
+  version_weaver::concurrent_catalog::reader reader(catalog);
+  ASSERT_TRUE(reader.pin().find("left-pad").empty());
+
+  std::vector<std::string> text = {"1.10.0", "1.2.0", "1.2.0-rc.1+build",
+                                   "2.0.0"};
+  catalog.publish("left-pad", parse_all(text));
+  // The catalog keeps its own copy of the text.
+  text.clear();
+  {
+    auto snapshot = reader.pin();
+    auto versions = snapshot.find("left-pad");
+    ASSERT_EQ(versions.size(), 4);
+    ASSERT_EQ(std::string(versions[0]), "1.2.0-rc.1+build");
+    ASSERT_EQ(std::string(versions[1]), "1.2.0");
+    ASSERT_EQ(std::string(versions[3]), "2.0.0");
+    ASSERT_TRUE(snapshot.find("right-pad").empty());
+  }
+
+  ASSERT_TRUE(catalog.erase("left-pad"));
+  ASSERT_FALSE(catalog.erase("left-pad"));
+  ASSERT_TRUE(reader.pin().find("left-pad").empty());
+}
+
+TEST(concurrentcatalogtests, snapshot_isolation) {
+  version_weaver::concurrent_catalog catalog;
+  catalog.publish("react", parse_all({"17.0.2", "18.2.0"}));
+  version_weaver::concurrent_catalog::reader reader(catalog);
+  auto snapshot = reader.pin();
+  auto before = snapshot.find("react");
+  ASSERT_EQ(before.size(), 2);
+
+  // A pinned snapshot keeps the list it saw, even once it is replaced.
+  catalog.publish("react", parse_all({"18.3.1"}));
+  catalog.erase("react");
+  ASSERT_EQ(std::string(before[1]), "18.2.0");
+  ASSERT_EQ(snapshot.find("react").size(), 2);
+
+  version_weaver::concurrent_catalog::reader other(catalog);
+  ASSERT_TRUE(other.pin().find("react").empty());
+}
+
+TEST(concurrentcatalogtests, concurrent_readers) {
+  version_weaver::concurrent_catalog catalog;
+  const std::vector<std::string> packages = {"a", "b", "c", "d"};
+  const auto first = make_generation(1, 50);
+  for (const auto& package : packages) {
+    catalog.publish(package, parse_all(first));
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> inconsistent{0};
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < 4; t++) {
+    readers.emplace_back([&]() {
+      version_weaver::concurrent_catalog::reader reader(catalog);
+      while (!done.load()) {
+        for (const auto& package : packages) {
+          auto snapshot = reader.pin();
+          auto versions = snapshot.find(package);
+          // Every list is sorted and belongs to a single generation.
+          bool consistent = versions.size() == 50;
+          for (size_t i = 1; consistent && i < versions.size(); i++) {
+            consistent = versions[i].major == versions[0].major &&
+                         versions[i - 1] < versions[i];
+          }
+          inconsistent += !consistent;
+        }
+      }
+    });
+  }
+  for (size_t generation = 2; generation < 300; generation++) {
+    const auto text = make_generation(generation, 50);
+    catalog.publish(packages[generation % packages.size()], parse_all(text));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(inconsistent.load(), 0);
+}
+
+TEST(concurrentcatalogtests, many_packages) {
+  // Enough packages for leaves to split into several trie levels.
+  version_weaver::concurrent_catalog catalog;
+  const std::vector<std::string> text = {"1.0.0", "2.0.0"};
+  const auto versions = parse_all(text);
+  const size_t count = 20000;
+  for (size_t i = 0; i < count; i++) {
+    catalog.publish("package-" + std::to_string(i),
+                    std::span(versions).first(1 + i % 2));
+  }
+  for (size_t i = 0; i < count; i += 2) {
+    ASSERT_TRUE(catalog.erase("package-" + std::to_string(i)));
+  }
+  version_weaver::concurrent_catalog::reader reader(catalog);
+  auto snapshot = reader.pin();
+  for (size_t i = 0; i < count; i++) {
+    auto found = snapshot.find("package-" + std::to_string(i));
+    ASSERT_EQ(found.size(), i % 2 == 0 ? 0 : 2) << i;
+  }
+  ASSERT_TRUE(snapshot.find("package-").empty());
+}
+
+TEST(concurrentcatalogtests, reclaims_on_release) {
+  version_weaver::concurrent_catalog catalog;
+  catalog.publish("react", parse_all({"17.0.2"}));
+  ASSERT_EQ(catalog.retired_count(), 0);
+  version_weaver::concurrent_catalog::reader reader(catalog);
+  {
+    auto snapshot = reader.pin();
+    catalog.publish("react", parse_all({"18.2.0"}));
+    catalog.publish("react", parse_all({"18.3.1"}));
+    // The snapshot may still see both replaced lists and their roots.
+    ASSERT_EQ(catalog.retired_count(), 4);
+    ASSERT_EQ(std::string(snapshot.find("react")[0]), "17.0.2");
+  }
+  // Releasing the last snapshot frees them, without waiting for a publish.
+  ASSERT_EQ(catalog.retired_count(), 0);
+
+  {
+    version_weaver::concurrent_catalog::reader other(catalog);
+    auto snapshot = other.pin();
+    catalog.erase("react");
+    ASSERT_EQ(catalog.retired_count(), 2);
+  }
+  ASSERT_EQ(catalog.retired_count(), 0);
+}
@@ -0,0 +1,597 @@
+#include "version_weaver/range.h"
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <random>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using RangeTestData = std::tuple<std::string_view, std::string_view, bool>;
+
+// https://github.com/npm/node-semver/blob/main/test/fixtures/range-include.js
+// https://github.com/npm/node-semver/blob/main/test/fixtures/range-exclude.js
+std::vector<RangeTestData> range_values = {
+    {"1.0.0", "1.0.0", true},
+    {"1.0.0", "1.0.1", false},
+    {"=1.0.0", "1.0.0", true},
+    {">=1.0.0", "1.0.0", true},
+    {">=1.0.0", "1.1.0", true},
+    {">1.0.0", "1.0.0", false},
+    {">1.0.0", "1.1.0", true},
+    {"<=2.0.0", "2.0.0", true},
+    {"<2.0.0", "2.0.0", false},
+    {"<2.0.0", "1.9999.9999", true},
+    {">= 1.0.0", "1.0.0", true},
+    {">=  1.0.0 <2.0.0", "1.5.0", true},
+    {">=1.0.0 <2.0.0", "2.0.0", false},
+    {"||", "1.3.4", true},
+    {"", "1.0.0", true},
+    {"*", "1.2.3", true},
+    {"x", "1.2.3", true},
+    {"2.x.x", "2.1.3", true},
+    {"1.2.x", "1.2.3", true},
+    {"1.2.x", "1.3.3", false},
+    {"1.2.x || 2.x", "2.1.3", true},
+    {"1.2.x || 2.x", "1.1.3", false},
+    {"2.*.*", "2.1.3", true},
+    {"2", "2.1.2", true},
+    {"2.3", "2.3.1", true},
+    {"2.3", "2.4.1", false},
+    {"v1.2.3", "1.2.3", true},
+    {"=v1.2.3", "1.2.3", true},
+    {"~2.4", "2.4.5", true},
+    {"~2.4", "2.5.0", false},
+    {"~>3.2.1", "3.2.2", true},
+    {"~1", "1.2.3", true},
+    {"~1", "2.0.0", false},
+    {"~> 1", "1.2.3", true},
+    {"~1.0", "1.0.2", true},
+    {"~ 1.0.3", "1.0.12", true},
+    {">=1", "1.0.0", true},
+    {">1", "1.9.9", false},
+    {">1", "2.0.0", true},
+    {"<1", "1.0.0-beta", false},
+    {"<=1.2", "1.2.9", true},
+    {"<=1.2", "1.3.0", false},
+    {"<1.2", "1.1.1", true},
+    {">1.2", "1.3.0", true},
+    {">1.2", "1.2.8", false},
+    {"<*", "1.0.0", false},
+    {">=*", "1.0.0", true},
+    {"^1.2.3", "1.8.1", true},
+    {"^1.2.3", "2.0.0-alpha", false},
+    {"^1.2.3", "1.2.2", false},
+    {"^1.2", "1.4.2", true},
+    {"^1.2", "1.1.9", false},
+    {"^1.2 ^1", "1.4.2", true},
+    {"^1.2.3-alpha", "1.2.3-pre", true},
+    {"^1.2.3-alpha", "1.2.4-pre", false},
+    {"^1.2.0-alpha", "1.2.0-pre", true},
+    {"^1.2.3+build", "1.2.3", true},
+    {"^1.2.3+build", "1.3.0", true},
+    {">1.2.3-alpha.3", "1.2.3-alpha.7", true},
+    {">1.2.3-alpha.3", "3.4.5-alpha.9", false},
+    {"1.2.3-alpha.3", "1.2.3-alpha.3", true},
+    {">=1.2.3-alpha.3 <2.0.0", "1.5.0-beta", false},
+    {"*", "1.2.3-beta", false},
+    {"1.2.3 >=1.2.1", "1.2.3", true},
+    {"1.0.0 - 2.0.0", "1.2.3", true},
+    {"1.0.0 - 2.0.0", "2.2.3", false},
+    {"1.2.3+asdf - 2.4.3+asdf", "1.2.3", true},
+    {"1.2.3-pre+asdf - 2.4.3-pre+asdf", "1.2.3", true},
+    {"1.2.3-pre+asdf - 2.4.3-pre+asdf", "2.4.3-alpha", true},
+    {"1.2.3-pre+asdf - 2.4.3-pre+asdf", "2.4.3", false},
+    {"1.2 - 2.3.4", "1.2.3", true},
+    {"1.2.3 - 2.3", "2.3.9", true},
+    {"1.2.3 - 2.3", "2.4.0-0", false},
+    {"1.2.3 - 2", "2.9.9", true},
+    {"1.2.3 - 2", "3.0.0", false},
+    {"* - 2", "1.0.0", true},
+    {"1.x - *", "9.9.9", true},
+    {"1.0.0 - 2.0.0 || 3.x", "3.1.0", true},
+    {">=1.2.1 1.2.3", "1.2.3", true},
+    {">=1.2.1 >=1.2.3", "1.2.3", true},
+    {">=1.2.1 >=1.2.3", "1.2.2", false},
+    {"1.x || 3.x", "2.0.0", false},
+    {"<1 || >2", "2.0.1", false},
+    {"<1 || >2", "3.0.1", true},
+    {"1.2.3", "1.2.3+asdf", true},
+    {"18446744073709551615.1.x", "18446744073709551615.1.1", true},
+    {"^1.2.3", "18446744073709551616.0.0", false},
+};
+
+TEST(rangetests, test) {
+  for (const auto& [range_text, version_text, expected] : range_values) {
+    auto parsed_range = version_weaver::parse_range(range_text);
+    ASSERT_TRUE(parsed_range.has_value()) << range_text;
+    auto v = version_weaver::parse(version_text);
+    ASSERT_TRUE(v.has_value()) << version_text;
+    ASSERT_EQ(parsed_range->test(*v), expected)
+        << range_text << " " << version_text;
+    ASSERT_EQ(version_weaver::satisfies(version_text, range_text), expected)
+        << range_text << " " << version_text;
+    ASSERT_EQ(version_weaver::compiled_range(*parsed_range).test(*v), expected)
+        << range_text << " " << version_text;
+  }
+}
+
+TEST(rangetests, compiled_range) {
+  std::vector<std::string_view> ranges = {
+      "^1.2.3",         "~0.2.1-beta.2", "<2.0.0 >=1.0.0-rc.1", "<2",
+      "<=1.4.0-alpha",  ">0.0.9 <0.1",   "0.x || 2.0.0-0",      "<*",
+      ">2097151.0.0",   "^2097151.2",    "1.2.3-alpha.3 || 3",  "<0.0.1-0",
+      "<1.0.0-beta >0", "2097152.x",     "<3.0.0 || >=4.0.0-2",
+  };
+  // Built directly, since parse() rejects a major of 0.
+  std::vector<version_weaver::version> versions = {
+      {"1", "0", "0"}, {"1", "2", "3"}, {"1", "4", "0"},
+      {"1", "4", "0", "alpha"}, {"1", "0", "0", "rc.0"},
+      {"1", "0", "0", "rc.2"}, {"1", "0", "0", "beta"}, {"0", "0", "5"},
+      {"0", "0", "9"}, {"0", "0", "10"}, {"0", "1", "0", "0"},
+      {"0", "2", "1", "beta.3"}, {"0", "2", "1"}, {"0", "2", "9"},
+      {"0", "3", "0"}, {"2", "0", "0", "0"}, {"2", "0", "0"}, {"2", "1", "0"},
+      {"1", "2", "3", "alpha.3"}, {"1", "2", "3", "alpha.2"}, {"3", "9", "9"},
+      {"4", "0", "0", "1"}, {"4", "0", "0", "2"}, {"4", "0", "0"},
+      {"2097151", "2", "0"}, {"2097152", "0", "0"}, {"2097151", "3", "0", "rc"},
+      {"2097152", "0", "0", "1"}, {"9", "2097152", "0"},
+      {"18446744073709551616", "0", "0"},
+  };
+  for (std::string_view range_text : ranges) {
+    auto parsed_range = version_weaver::parse_range(range_text);
+    ASSERT_TRUE(parsed_range.has_value()) << range_text;
+    version_weaver::compiled_range compiled(*parsed_range);
+    ASSERT_EQ(compiled.source().text(), range_text);
+    for (const auto& v : versions) {
+      ASSERT_EQ(compiled.test(v), parsed_range->test(v))
+          << range_text << " " << std::string(v);
+    }
+  }
+}
+
+using OptionsTestData = std::tuple<std::string_view, std::string_view,
+                                   version_weaver::range_options, bool>;
+
+constexpr version_weaver::range_options INCLUDE_PRERELEASE = {true, false};
+constexpr version_weaver::range_options LOOSE = {false, true};
+
+// https://github.com/npm/node-semver/blob/main/test/fixtures/range-include.js
+// https://github.com/npm/node-semver/blob/main/test/fixtures/range-exclude.js
+std::vector<OptionsTestData> options_values = {
+    {"*", "1.0.0-rc1", INCLUDE_PRERELEASE, true},
+    {"^2 <2.2 || > 2.3", "2.2.1-pre", INCLUDE_PRERELEASE, false},
+    {"^1.0.0", "1.1.0-beta", INCLUDE_PRERELEASE, true},
+    {"^1.0.0", "2.0.0-rc", INCLUDE_PRERELEASE, false},
+    {"^1.2.3", "1.2.3-rc", INCLUDE_PRERELEASE, false},
+    {"1.x", "1.0.0-alpha", INCLUDE_PRERELEASE, true},
+    {"1.x", "1.0.0-alpha", {}, false},
+    {"^1", "1.0.0-0", INCLUDE_PRERELEASE, true},
+    {">=1.2", "1.2.0-beta", INCLUDE_PRERELEASE, true},
+    {">1", "2.0.0-beta", INCLUDE_PRERELEASE, true},
+    {"~1", "1.0.0-beta", INCLUDE_PRERELEASE, false},
+    {">=1.0.0 <1.1.0", "1.1.0-alpha", INCLUDE_PRERELEASE, true},
+    {">=1.0.0 <1.1.0", "1.1.0-alpha", {}, false},
+    {"1.2.3foo", "1.2.3-foo", LOOSE, true},
+    {"1.2.3pre.1", "1.2.3-pre.2", LOOSE, false},
+    {"~1.2.3beta", "1.2.4-beta", LOOSE, false},
+    {"~1.2.3beta", "1.2.3-beta.1", LOOSE, true},
+    {">=01.02.03", "1.2.3", LOOSE, true},
+    {"=1.7.x", "1.7.0-asdf", LOOSE, false},
+    {"<=1.2.x", "1.2.9", LOOSE, true},
+};
+
+TEST(rangetests, options) {
+  for (const auto& [range_text, version_text, options, expected] :
+       options_values) {
+    auto parsed_range = version_weaver::parse_range(range_text, options);
+    ASSERT_TRUE(parsed_range.has_value()) << range_text;
+    ASSERT_EQ(parsed_range->options().include_prerelease,
+              options.include_prerelease);
+    auto v = version_weaver::parse(version_text);
+    ASSERT_TRUE(v.has_value()) << version_text;
+    ASSERT_EQ(parsed_range->test(*v), expected)
+        << range_text << " " << version_text;
+    ASSERT_EQ(version_weaver::satisfies(version_text, range_text, options),
+              expected)
+        << range_text << " " << version_text;
+    ASSERT_EQ(version_weaver::compiled_range(*parsed_range).test(*v), expected)
+        << range_text << " " << version_text;
+  }
+  for (std::string_view strict : {"1.2.3foo", ">=01.02.03", "^1.2.3beta"}) {
+    ASSERT_FALSE(version_weaver::parse_range(strict).has_value()) << strict;
+  }
+  ASSERT_FALSE(version_weaver::parse_range("1.2.3foo!", LOOSE).has_value());
+}
+
+TEST(rangetests, canonical) {
+  auto canonical = [](std::string_view text,
+                      version_weaver::range_options options = {}) {
+    return version_weaver::parse_range(text, options).value().canonical();
+  };
+  ASSERT_EQ(canonical("^1.2.3-beta || 2.0.0 || *"),
+            ">=1.2.3-beta <2.0.0-0 || 2.0.0 || *");
+  ASSERT_EQ(canonical("1.x"), ">=1.0.0 <2.0.0-0");
+  ASSERT_EQ(canonical("1.x", {.include_prerelease = true}),
+            ">=1.0.0-0 <2.0.0-0");
+
+  std::vector<std::vector<std::string_view>> same = {
+      {"1.x", "1.*", "1", "1.X.x", "^1", "~1", ">=1 <2.0.0-0", "<2 >=1.0"},
+      {"1.2.3 - 2.3", ">=1.2.3 <2.4.0-0", "<2.4.0-0 >=1.2.3 >=1.2.3"},
+      {"*", "x", "", ">=*", "^*"},
+      {"1.2.3", "=v1.2.3", "1.2.3+build"},
+  };
+  for (size_t i = 0; i < same.size(); i++) {
+    for (size_t j = 0; j < same.size(); j++) {
+      for (std::string_view a : same[i]) {
+        for (std::string_view b : same[j]) {
+          auto first = version_weaver::parse_range(a).value();
+          auto second = version_weaver::parse_range(b).value();
+          ASSERT_EQ(first == second, i == j) << a << " " << b;
+          ASSERT_EQ(first.canonical() == second.canonical(), i == j)
+              << a << " " << b;
+        }
+      }
+    }
+  }
+  ASSERT_NE(version_weaver::parse_range("1.x").value(),
+            version_weaver::parse_range("^1.0.0-0").value());
+  ASSERT_EQ(
+      version_weaver::parse_range("1.x", {.include_prerelease = true}).value(),
+      version_weaver::parse_range("^1.0.0-0", {.include_prerelease = true})
+          .value());
+  ASSERT_NE(
+      version_weaver::parse_range("1.2.3", {.include_prerelease = true})
+          .value(),
+      version_weaver::parse_range("1.2.3").value());
+
+  version_weaver::range_cache cache({.include_prerelease = true});
+  auto first = cache.get("1.x");
+  ASSERT_TRUE(first.has_value());
+  ASSERT_EQ(cache.get("1.*").value(), *first);
+  ASSERT_EQ(cache.get("^1.0.0-0").value(), *first);
+  ASSERT_EQ(cache.get("1.x").value(), *first);
+  ASSERT_NE(cache.get("2.x").value(), *first);
+  ASSERT_EQ(cache.get("=>1").error(), version_weaver::INVALID_OPERATOR);
+  ASSERT_EQ(cache.spelling_count(), 4);
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_TRUE((*first)->test(version_weaver::parse("1.0.0-alpha").value()));
+  ASSERT_EQ((*first)->source().text(), "1.x");
+}
+
+TEST(rangetests, memory_resource) {
+  // Nothing may come from the default resource while the ranges are built.
+  std::pmr::memory_resource* previous =
+      std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  std::array<std::byte, 16384> buffer;
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(),
+                                            std::pmr::null_memory_resource());
+  auto parsed =
+      version_weaver::parse_range(">=1.0.0 <2.0.0 || ~2.4", {}, &arena);
+  std::pmr::string canonical = parsed->canonical(&arena);
+  std::pmr::string simplified(&arena);
+  version_weaver::simplify(*parsed, simplified);
+  version_weaver::compiled_range compiled(std::move(*parsed));
+  bool matches = compiled.test(version_weaver::parse("2.4.9").value());
+  std::vector<version_weaver::version> universe = {
+      version_weaver::parse("1.5.0").value(),
+      version_weaver::parse("2.4.1").value()};
+  std::pmr::string narrowed(&arena);
+  version_weaver::simplify(compiled.source(), universe, narrowed);
+  version_weaver::range_cache cache({}, &arena);
+  auto cached = cache.get("1.x");
+  auto respelled = cache.get("^1.0.0");
+  std::pmr::set_default_resource(previous);
+
+  std::string expected;
+  version_weaver::simplify(
+      version_weaver::parse_range(">=1.0.0 <2.0.0 || ~2.4").value(), expected);
+  ASSERT_EQ(std::string_view(simplified), expected);
+  ASSERT_EQ(std::string_view(canonical),
+            version_weaver::parse_range(">=1.0.0 <2.0.0 || ~2.4")->canonical());
+  ASSERT_TRUE(matches);
+  std::string expected_narrowed;
+  version_weaver::simplify(compiled.source(), universe, expected_narrowed);
+  ASSERT_EQ(std::string_view(narrowed), expected_narrowed);
+  ASSERT_EQ(compiled.source().text(), ">=1.0.0 <2.0.0 || ~2.4");
+  ASSERT_EQ(cached.value(), respelled.value());
+  ASSERT_EQ(cache.size(), 1);
+}
+
+template <version_weaver::fixed_string Text>
+void expect_static_matches(std::span<const std::string_view> versions) {
+  auto parsed_range = version_weaver::parse_range(Text.view());
+  ASSERT_TRUE(parsed_range.has_value()) << Text.view();
+  for (std::string_view text : versions) {
+    auto v = version_weaver::parse(text);
+    ASSERT_TRUE(v.has_value()) << text;
+    ASSERT_EQ(version_weaver::static_range<Text>::test(*v),
+              parsed_range->test(*v))
+        << Text.view() << " " << text;
+  }
+}
+
+TEST(rangetests, static_range) {
+  using node = version_weaver::static_range<">=18.0.0 <23.0.0">;
+  static_assert(node::test(version_weaver::parse("20.1.0").value()));
+  static_assert(!node::test(version_weaver::parse("23.0.0").value()));
+  static_assert(!node::test(version_weaver::parse("22.0.0-rc.1").value()));
+  static_assert(
+      version_weaver::static_range<"^1.2.3-alpha || 3.x">::test(
+          version_weaver::parse("1.2.3-beta").value()));
+
+  constexpr std::string_view versions[] = {
+      "1.0.0",       "1.2.2",      "1.2.3-alpha", "1.2.3-beta", "1.2.3",
+      "1.9.9",       "2.0.0-rc.1", "2.0.0",       "2.4.1",      "3.0.0",
+      "3.1.0-pre",   "17.9.0",     "18.0.0",      "22.9.9",     "23.0.0",
+      "1.2.3+build",
+  };
+  expect_static_matches<">=18.0.0 <23.0.0">(versions);
+  expect_static_matches<"^1.2.3-alpha || 3.x">(versions);
+  expect_static_matches<"~2.4 || <=1.2 || >22">(versions);
+  expect_static_matches<"1.2.x || >=2.0.0-rc.0 <2.0.0">(versions);
+  expect_static_matches<"">(versions);
+  expect_static_matches<"<*">(versions);
+}
+
+TEST(rangetests, simplify) {
+  constexpr std::string_view versions[] = {
+      "1.0.0",     "1.1.0",     "1.2.0-rc",  "1.2.0", "1.2.3-beta",
+      "1.2.3",     "1.5.0",     "1.9.9",     "2.0.0-0", "2.0.0-rc.1",
+      "2.0.0",     "2.4.1",     "2.5.0-pre", "3.0.0", "3.1.0",
+      "10.0.0",
+  };
+  std::vector<version_weaver::version> universe;
+  for (std::string_view text : versions) {
+    universe.push_back(version_weaver::parse(text).value());
+  }
+  std::string output;
+  auto simplified = [&](std::string_view text,
+                        version_weaver::range_options options = {}) {
+    auto parsed = version_weaver::parse_range(text, options).value();
+    std::string result(version_weaver::simplify(parsed, output));
+    auto reparsed = version_weaver::parse_range(result, options);
+    EXPECT_TRUE(reparsed.has_value()) << text << " " << result;
+    for (const auto& v : universe) {
+      EXPECT_EQ(reparsed->test(v), parsed.test(v))
+          << text << " " << result << " " << std::string(v);
+    }
+    return result;
+  };
+  ASSERT_EQ(simplified(">=1.2.0 <2.0.0 || >=1.5.0 <2.0.0"), "^1.2.0");
+  ASSERT_EQ(simplified(">=1.2.0 <2.0.0 || >=1.5.0"), ">=1.2.0");
+  ASSERT_EQ(simplified(">=1.0.2 <1.0.5 || >=1.0.5 <1.1.0-0"), "~1.0.2");
+  ASSERT_EQ(simplified(">=1.0.0 <=2.0.0 || 1.5.0"), "1.0.0 - 2.0.0");
+  ASSERT_EQ(simplified("=1.2.3 >1.0.0"), "1.2.3");
+  ASSERT_EQ(simplified("1.x || >=1.2.0 <2.0.0-0"), "1.x");
+  ASSERT_EQ(simplified(">=1.2.0 <1.3.0-0 || 1.2.9"), "1.2.x");
+  ASSERT_EQ(simplified(">=0.0.0 || 1.x || 3"), "*");
+  ASSERT_EQ(simplified(">2.0.0 <1.0.0 || 3.0.0 <3.0.0"), "<0.0.0-0");
+  ASSERT_EQ(simplified(">=1.0.0 <2.0.0 || >2.0.0 <3.0.0"),
+            "1.x || >2.0.0 <3.0.0");
+  ASSERT_EQ(simplified("^1.2.3 || >=1.2.3 <2.0.0-0 || ~2.4.0"),
+            "^1.2.3 || 2.4.x");
+  // Sets with pre-release bounds keep their own pre-releases.
+  ASSERT_EQ(simplified("^1.2.3-beta || >=1.0.0 <3.0.0 || 2.x"),
+            ">=1.0.0 <3.0.0 || ^1.2.3-beta");
+  ASSERT_EQ(simplified(">=1.2.3-beta >=1.0.0 <2.0.0-0"), "^1.2.3-beta");
+  ASSERT_EQ(simplified(">=1.0.0-0 <2.0.0-0 || >=2.0.0-0 <3.0.0-0",
+                       {.include_prerelease = true}),
+            ">=1.0.0-0 <3.0.0-0");
+  ASSERT_EQ(simplified(">=1.0.0-0 <2.0.0-0 || >=1.5.0 <2.0.0-0",
+                       {.include_prerelease = true}),
+            "1.x");
+  ASSERT_EQ(simplified(">1 <3"), "2.x");
+  // The text is kept when it is no longer.
+  ASSERT_EQ(simplified("^1.2.3"), "^1.2.3");
+  ASSERT_EQ(simplified("1.x || 2.x", {.include_prerelease = true}),
+            "1.x || 2.x");
+
+  auto over_universe = [&](std::string_view text) {
+    auto parsed = version_weaver::parse_range(text).value();
+    return std::string(version_weaver::simplify(parsed, universe, output));
+  };
+  ASSERT_EQ(over_universe("1.0.0 || 1.1.0"), "<=1.1.0");
+  ASSERT_EQ(over_universe(">=1.9.0 <2.1.0 || 2.4.1 || >=3.0.0 <3.0.1"),
+            "1.9.9 || 2.0.0 - 2.4.1 || 3.0.0");
+  ASSERT_EQ(over_universe("3.0.0 || 3.1.0 || 10.0.0"), ">=3.0.0");
+  ASSERT_EQ(over_universe("1.2.3-beta || 1.2.3 || 1.5.0"),
+            "1.2.3-beta - 1.5.0");
+  // "1.2.0 - 1.2.3" would leave out 1.2.3-beta.
+  ASSERT_EQ(over_universe("1.2.0 || 1.2.3-beta || 1.2.3"),
+            "1.2.0 || 1.2.3-beta || 1.2.3");
+}
+
+TEST(rangetests, max_satisfying) {
+  auto parse_all = [](std::vector<std::string_view> texts) {
+    std::vector<version_weaver::version> result;
+    for (std::string_view text : texts) {
+      result.push_back(version_weaver::parse(text).value());
+    }
+    return result;
+  };
+  auto text_of = [](const std::optional<version_weaver::version>& v) {
+    return v.has_value() ? std::string(*v) : std::string("none");
+  };
+  // https://github.com/npm/node-semver/blob/main/test/ranges/max-satisfying.js
+  auto versions = parse_all({"1.2.3", "1.2.4", "1.2.5", "1.2.6", "2.0.1"});
+  auto tilde = version_weaver::parse_range("~1.2.3").value();
+  ASSERT_EQ(text_of(version_weaver::max_satisfying(versions, tilde)), "1.2.6");
+  ASSERT_EQ(text_of(version_weaver::min_satisfying(versions, tilde)), "1.2.3");
+  auto unordered = parse_all({"1.1.0", "1.2.0", "1.2.1", "1.3.0", "2.0.0-b1",
+                              "2.0.0-b2", "2.0.0-b3", "2.0.0", "2.1.0"});
+  auto pre = version_weaver::parse_range("~2.0.0-b1").value();
+  ASSERT_EQ(text_of(version_weaver::max_satisfying(unordered, pre)), "2.0.0");
+  ASSERT_EQ(text_of(version_weaver::min_satisfying(unordered, pre)),
+            "2.0.0-b1");
+  auto none = version_weaver::parse_range("~3").value();
+  ASSERT_EQ(text_of(version_weaver::max_satisfying(unordered, none)), "none");
+  ASSERT_EQ(text_of(version_weaver::min_satisfying({}, tilde)), "none");
+
+  // Spans of several chunks, in random order, with pre-releases sharing a
+  // major.minor.patch and components too large to pack.
+  std::mt19937_64 rng(7);
+  std::vector<std::string> texts;
+  for (size_t i = 0; i < 500; i++) {
+    std::string text = std::to_string(1 + rng() % 4) + "." +
+                       std::to_string(rng() % 3) + "." +
+                       std::to_string(rng() % 3);
+    if (rng() % 3 == 0) {
+      text += "-rc." + std::to_string(rng() % 5);
+    }
+    texts.push_back(text);
+  }
+  texts.push_back("2.3000000.0");
+  texts.push_back("4.2.2-rc.9");
+  std::shuffle(texts.begin(), texts.end(), rng);
+  std::vector<version_weaver::version> many;
+  for (const std::string& text : texts) {
+    many.push_back(version_weaver::parse(text).value());
+  }
+  for (std::string_view range_text :
+       {"^2.0.0", "<2.1.0-rc.2 >=2.0.0-rc.1", "2.x || 4.2.2-rc.4", "*",
+        ">=4.2.2-rc.0", "<1.0.0"}) {
+    for (bool include_prerelease : {false, true}) {
+      auto parsed = version_weaver::parse_range(
+                        range_text, {.include_prerelease = include_prerelease})
+                        .value();
+      std::optional<version_weaver::version> highest;
+      std::optional<version_weaver::version> lowest;
+      for (const auto& v : many) {
+        if (parsed.test(v)) {
+          highest = !highest || *highest < v ? v : *highest;
+          lowest = !lowest || v < *lowest ? v : *lowest;
+        }
+      }
+      ASSERT_EQ(text_of(version_weaver::max_satisfying(many, parsed)),
+                text_of(highest))
+          << range_text;
+      ASSERT_EQ(text_of(version_weaver::min_satisfying(many, parsed)),
+                text_of(lowest))
+          << range_text;
+    }
+  }
+}
+
+TEST(rangetests, desugar) {
+  using version_weaver::comparator;
+  auto expect_set = [](std::string_view text,
+                       std::vector<std::string_view> expected) {
+    auto parsed = version_weaver::parse_range(text);
+    ASSERT_TRUE(parsed.has_value()) << text;
+    ASSERT_EQ(parsed->size(), 1);
+    auto set = parsed->set(0);
+    ASSERT_EQ(set.size(), expected.size()) << text;
+    const char* ops[] = {"<", "<=", ">", ">=", "="};
+    for (size_t i = 0; i < set.size(); i++) {
+      const comparator& c = set[i];
+      std::string written = std::string(ops[c.op]) + std::to_string(c.major) +
+                            "." + std::to_string(c.minor) + "." +
+                            std::to_string(c.patch);
+      if (c.pre_release) {
+        written += "-" + std::string(*c.pre_release);
+      }
+      ASSERT_EQ(written, expected[i]) << text;
+    }
+  };
+  expect_set("^0.0.3", {">=0.0.3", "<0.0.4-0"});
+  expect_set("^0.2.3", {">=0.2.3", "<0.3.0-0"});
+  expect_set("^0.2", {">=0.2.0", "<0.3.0-0"});
+  expect_set("^0", {">=0.0.0", "<1.0.0-0"});
+  expect_set("^1.2.3-beta.2", {">=1.2.3-beta.2", "<2.0.0-0"});
+  expect_set("~1.2.3-beta.2", {">=1.2.3-beta.2", "<1.3.0-0"});
+  expect_set("1.x", {">=1.0.0", "<2.0.0-0"});
+  expect_set(">1.x", {">=2.0.0"});
+  expect_set("<=1.2.x", {"<1.3.0-0"});
+  expect_set(">*", {"<0.0.0-0"});
+  expect_set("^*", {});
+  expect_set("1.2 - 2.3.4", {">=1.2.0", "<=2.3.4"});
+  expect_set("1.2.3 - 2", {">=1.2.3", "<3.0.0-0"});
+  expect_set("* - 2.x", {"<3.0.0-0"});
+  // Sets are sorted into lower bounds, exact versions and upper bounds.
+  expect_set("<2 1.5.0 >=1.2.3 >=1.2.3 >1.2.3",
+             {">1.2.3", ">=1.2.3", "=1.5.0", "<2.0.0-0"});
+
+  version_weaver::version v{"0", "2", "5"};
+  auto caret = version_weaver::parse_range("^0.2.3");
+  ASSERT_TRUE(caret.has_value());
+  ASSERT_TRUE(caret->test(v));
+  ASSERT_FALSE(caret->test({"0", "3", "0"}));
+
+  // Copies share the text that pre-release bounds point into.
+  auto original = version_weaver::parse_range(">=1.2.3-rc.1");
+  ASSERT_TRUE(original.has_value());
+  version_weaver::range copy = *original;
+  original = version_weaver::parse_range("*");
+  ASSERT_TRUE(copy.test(version_weaver::parse("1.2.3-rc.2").value()));
+  ASSERT_FALSE(copy.test(version_weaver::parse("1.2.3-rc.0").value()));
+}
+
+TEST(rangetests, errors) {
+  std::vector<std::pair<std::string_view, version_weaver::range_error>>
+      values = {
+          {">=", version_weaver::INVALID_BOUND},
+          {"blerg", version_weaver::INVALID_BOUND},
+          {"1.2.3.4", version_weaver::INVALID_BOUND},
+          {"01.2.3", version_weaver::INVALID_BOUND},
+          {"1.2-beta", version_weaver::INVALID_BOUND},
+          {"1.2.3-beta..1", version_weaver::INVALID_BOUND},
+          {"1.2.3 | 2.0.0", version_weaver::INVALID_BOUND},
+          {"1.0.0 -2.0.0", version_weaver::INVALID_BOUND},
+          {"1.0.0 - ", version_weaver::INVALID_BOUND},
+          {"^1.0.0 - 2.0.0", version_weaver::INVALID_BOUND},
+          {"1.0.0 - 2.0.0-01", version_weaver::INVALID_BOUND},
+          {"18446744073709551616", version_weaver::INVALID_BOUND},
+          {"^18446744073709551615.1.2", version_weaver::INVALID_BOUND},
+          {"=>1.2.3", version_weaver::INVALID_OPERATOR},
+          {"<>1.2.3", version_weaver::INVALID_OPERATOR},
+      };
+  for (const auto& [text, error] : values) {
+    auto parsed = version_weaver::parse_range(text);
+    ASSERT_FALSE(parsed.has_value()) << text;
+    ASSERT_EQ(parsed.error(), error) << text;
+  }
+  ASSERT_FALSE(version_weaver::satisfies("not a version", "*"));
+  ASSERT_FALSE(version_weaver::satisfies("1.2.3", ">=blerg"));
+}
+
+TEST(rangetests, verify_lockfile) {
+  std::vector<version_weaver::locked_pair> pairs = {
+      {"^1.2.0", "1.4.2"}, {"^1.2.0", "2.0.0"}, {"~2.1", "2.1.9"},
+      {"=>1", "1.0.0"},    {"^1.2.0", "1.x"},   {">=1.0.0-rc.1", "1.0.0-rc.2"},
+      {"^1.2.0", "1.2.0"}, {"=>1", "2.0.0"},
+  };
+  auto failures = version_weaver::verify_lockfile(pairs);
+  std::vector<std::pair<size_t, version_weaver::verify_error>> expected = {
+      {1, version_weaver::UNSATISFIED},
+      {3, version_weaver::INVALID_LOCKED_RANGE},
+      {4, version_weaver::INVALID_LOCKED_VERSION},
+      {7, version_weaver::INVALID_LOCKED_RANGE},
+  };
+  ASSERT_EQ(failures.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(failures[i].index, expected[i].first);
+    ASSERT_EQ(failures[i].error, expected[i].second);
+  }
+  ASSERT_TRUE(version_weaver::verify_lockfile({}).empty());
+
+  // Chunks are checked in parallel, and failures still come back in order.
+  std::vector<std::string> versions;
+  for (size_t i = 0; i < 4 * version_weaver::PARALLEL_VERIFY_THRESHOLD; i++) {
+    versions.push_back("1." + std::to_string(i % 50) + ".0");
+  }
+  std::vector<version_weaver::locked_pair> batch;
+  for (size_t i = 0; i < versions.size(); i++) {
+    batch.push_back({i % 3 == 0 ? "~1.7.0" : "^1.0.0", versions[i]});
+  }
+  auto sequential = version_weaver::verify_lockfile(batch);
+  auto parallel = version_weaver::verify_lockfile(batch, 4);
+  ASSERT_EQ(sequential.size(), parallel.size());
+  for (size_t i = 0; i < sequential.size(); i++) {
+    ASSERT_EQ(sequential[i].index, parallel[i].index);
+    ASSERT_EQ(batch[sequential[i].index].range, "~1.7.0");
+    ASSERT_NE(batch[sequential[i].index].version, "1.7.0");
+  }
+  ASSERT_FALSE(sequential.empty());
+}
@@ -0,0 +1,194 @@
+#include "version_weaver/resolver.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+constexpr std::string_view REGISTRY = R"(# name	version	dependencies...
+app	1.0.0	lib	^1.0.0	util	~2.1.0
+lib	1.0.0	util	^2.0.0
+lib	1.4.0	util	^2.0.0
+lib	1.5.0	missing	^1.0.0
+lib	2.0.0	util	^3.0.0
+util	2.0.0
+util	2.1.3
+util	3.1.0
+cycle-a	1.0.0	cycle-b	^1.0.0
+cycle-b	1.0.0	cycle-a	^1.0.0
+broken	1.0.0	lib	>=3.0.0
+)";
+
+// The selected version of every dependency of `index`, as "name@version".
+std::vector<std::string> dependencies_of(
+    const version_weaver::resolution& result, size_t index) {
+  std::vector<std::string> names;
+  for (size_t child : result.packages[index].dependencies) {
+    const auto& package = result.packages[child];
+    names.push_back(std::string(package.name) + "@" +
+                    std::string(package.release));
+  }
+  return names;
+}
+
+TEST(resolvertests, registry) {
+  auto packages = version_weaver::registry::parse(REGISTRY);
+  ASSERT_TRUE(packages.has_value());
+  ASSERT_EQ(packages->size(), 6);
+  const auto* lib = packages->find("lib");
+  ASSERT_NE(lib, nullptr);
+  ASSERT_EQ(lib->versions.size(), 4);
+  ASSERT_EQ(std::string(lib->versions.back().release), "2.0.0");
+  ASSERT_EQ(lib->versions[0].dependencies[0].range, "^2.0.0");
+  ASSERT_EQ(packages->find("left-pad"), nullptr);
+
+  for (std::string_view text :
+       {"lib\n", "lib\tnot-a-version\n", "lib\t1.0.0\tutil\n",
+        "lib\t1.0.0\tutil\t=>1\n", "\t1.0.0\n"}) {
+    auto invalid = version_weaver::registry::parse(text);
+    ASSERT_FALSE(invalid.has_value()) << text;
+    ASSERT_EQ(invalid.error(), version_weaver::INVALID_REGISTRY);
+  }
+
+  auto path = std::filesystem::temp_directory_path() / "resolvertests.tsv";
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << REGISTRY;
+  }
+  auto loaded = version_weaver::registry::load(path.string());
+  std::filesystem::remove(path);
+  ASSERT_TRUE(loaded.has_value());
+  ASSERT_EQ(loaded->size(), 6);
+  ASSERT_EQ(version_weaver::registry::load(path.string()).error(),
+            version_weaver::REGISTRY_IO_ERROR);
+}
+
+TEST(resolvertests, resolve) {
+  auto packages = version_weaver::registry::parse(REGISTRY).value();
+  std::vector<version_weaver::dependency> manifest = {{"app", "*"},
+                                                      {"util", "^2.0.0"}};
+  auto result = version_weaver::resolve(packages, manifest);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(result->roots.size(), 2);
+  // lib 1.5.0 needs a package the registry does not have, so resolution
+  // backtracks to lib 1.4.0. Every ^2.0.0 and ~2.1.0 range shares util 2.1.3.
+  ASSERT_EQ(dependencies_of(*result, result->roots[0]),
+            (std::vector<std::string>{"lib@1.4.0", "util@2.1.3"}));
+  ASSERT_EQ(result->packages.size(), 3);
+  ASSERT_EQ(std::string(result->packages[result->roots[1]].release), "2.1.3");
+
+  // Ranges that do not intersect get their own versions.
+  std::vector<version_weaver::dependency> split = {{"lib", "^2.0.0"},
+                                                   {"util", "~2.0.0"}};
+  result = version_weaver::resolve(packages, split);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(dependencies_of(*result, result->roots[0]),
+            (std::vector<std::string>{"util@3.1.0"}));
+  ASSERT_EQ(std::string(result->packages[result->roots[1]].release), "2.0.0");
+
+  std::vector<version_weaver::dependency> cycle = {{"cycle-a", "^1.0.0"}};
+  result = version_weaver::resolve(packages, cycle);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(result->packages.size(), 2);
+  ASSERT_EQ(dependencies_of(*result, 1),
+            (std::vector<std::string>{"cycle-a@1.0.0"}));
+
+  std::vector<version_weaver::dependency> broken = {{"broken", "*"}};
+  ASSERT_EQ(version_weaver::resolve(packages, broken).error(),
+            version_weaver::UNRESOLVABLE);
+  std::vector<version_weaver::dependency> unknown = {{"left-pad", "*"}};
+  ASSERT_EQ(version_weaver::resolve(packages, unknown).error(),
+            version_weaver::UNRESOLVABLE);
+  std::vector<version_weaver::dependency> invalid = {{"lib", "=>1"}};
+  ASSERT_EQ(version_weaver::resolve(packages, invalid).error(),
+            version_weaver::INVALID_MANIFEST_RANGE);
+}
+
+TEST(resolvertests, empty_manifest) {
+  auto packages = version_weaver::registry::parse(REGISTRY).value();
+  for (size_t threads : {0, 1, 4}) {
+    auto result = version_weaver::resolve(packages, {}, {.threads = threads});
+    ASSERT_TRUE(result.has_value()) << threads;
+    ASSERT_TRUE(result->packages.empty());
+    ASSERT_TRUE(result->roots.empty());
+  }
+}
+
+TEST(resolvertests, threads) {
+  // Layers of packages, each depending on a few packages of the next layer.
+  std::string text;
+  const size_t layers = 6;
+  const size_t width = 40;
+  for (size_t layer = 0; layer < layers; layer++) {
+    for (size_t i = 0; i < width; i++) {
+      for (size_t minor = 0; minor < 3; minor++) {
+        text += "p" + std::to_string(layer) + "-" + std::to_string(i) + "\t1." +
+                std::to_string(minor) + ".0";
+        for (size_t d = 0; layer + 1 < layers && d < 3; d++) {
+          text += "\tp" + std::to_string(layer + 1) + "-" +
+                  std::to_string((i * 7 + d * 13 + minor) % width) + "\t^1." +
+                  std::to_string((i + d) % 3) + ".0";
+        }
+        text += "\n";
+      }
+    }
+  }
+  auto packages = version_weaver::registry::parse(text).value();
+  std::vector<std::string> names;
+  for (size_t i = 0; i < width; i++) {
+    names.push_back("p0-" + std::to_string(i));
+  }
+  std::vector<version_weaver::dependency> manifest;
+  for (const auto& name : names) {
+    manifest.push_back({name, "^1.0.0"});
+  }
+  auto sequential = version_weaver::resolve(packages, manifest);
+  auto parallel = version_weaver::resolve(packages, manifest, {.threads = 4});
+  ASSERT_TRUE(sequential.has_value());
+  ASSERT_TRUE(parallel.has_value());
+  ASSERT_EQ(sequential->roots, parallel->roots);
+  ASSERT_EQ(sequential->packages.size(), parallel->packages.size());
+  for (size_t i = 0; i < sequential->packages.size(); i++) {
+    ASSERT_EQ(sequential->packages[i].name, parallel->packages[i].name);
+    ASSERT_TRUE(version_weaver::identical(sequential->packages[i].release,
+                                          parallel->packages[i].release));
+    ASSERT_EQ(sequential->packages[i].dependencies,
+              parallel->packages[i].dependencies);
+  }
+}
+
+TEST(resolvertests, remembers_failures) {
+  // A chain of packages with four versions each, whose last link depends on
+  // a package that does not exist. Without remembering that a link failed,
+  // every version of every link would be tried again: 4^32 searches.
+  std::string text;
+  const size_t depth = 32;
+  for (size_t link = 0; link < depth; link++) {
+    std::string next =
+        link + 1 < depth ? "link" + std::to_string(link + 1) : "missing";
+    for (size_t minor = 0; minor < 4; minor++) {
+      text += "link" + std::to_string(link) + "\t1." + std::to_string(minor) +
+              ".0\t" + next + "\t^1.0.0\n";
+    }
+  }
+  // The same chain, whose last link can also be satisfied by an older
+  // version that reaches back to the start of the chain.
+  text += "loop0\t1.0.0\tloop1\t^1.0.0\n";
+  text += "loop1\t1.0.0\tloop2\t^1.0.0\n";
+  text += "loop1\t1.1.0\tloop2\t^1.0.0\n";
+  text += "loop2\t1.0.0\tloop0\t^1.0.0\n";
+  text += "loop2\t1.1.0\tmissing\t^1.0.0\n";
+  auto packages = version_weaver::registry::parse(text).value();
+  std::vector<version_weaver::dependency> manifest = {{"link0", "^1.0.0"}};
+  ASSERT_EQ(version_weaver::resolve(packages, manifest).error(),
+            version_weaver::UNRESOLVABLE);
+
+  std::vector<version_weaver::dependency> loop = {{"loop0", "^1.0.0"}};
+  auto result = version_weaver::resolve(packages, loop);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(dependencies_of(*result, result->roots[0]),
+            (std::vector<std::string>{"loop1@1.1.0"}));
+  ASSERT_EQ(dependencies_of(*result, 1),
+            (std::vector<std::string>{"loop2@1.0.0"}));
+}
@@ -0,0 +1,392 @@
+// version_weaver: command-line tools over newline-delimited versions.
+//
+//   version_weaver [-j|--threads THREADS] COMMAND [RANGE] [FILE]
+//
+// Reads FILE, which is memory-mapped, or the standard input in large blocks.
+// Output is collected in large buffers and written with few calls. Commands:
+//
+//   validate             print the lines that are not valid versions
+//   sort                 print the valid versions by precedence, lowest first
+//   uniq                 like sort, keeping one version per precedence
+//   max-satisfying RANGE print the highest version satisfying RANGE
+//   filter RANGE         print the versions satisfying RANGE, in input order
+//   coerce               print the version coerced out of every line
+//
+// Lines that are not valid versions are skipped by every command but validate
+// and coerce. The exit status is 1 when validate finds an invalid line or
+// max-satisfying finds no match, and 2 on usage or input errors.
+#include "version_weaver.h"
+#include "version_weaver/catalog.h"
+#include "version_weaver/range.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bytes read from the standard input at a time.
+constexpr size_t BLOCK_SIZE = 16 << 20;
+// Blocks smaller than this are not worth splitting across threads.
+constexpr size_t MIN_PARALLEL_BLOCK = 1 << 20;
+
+// Collects output and writes it with large fwrite calls.
+class output_buffer {
+ public:
+  static constexpr size_t CAPACITY = 1 << 20;
+
+  output_buffer() { buffer_.reserve(CAPACITY); }
+  ~output_buffer() { flush(); }
+
+  void write_line(std::string_view line) {
+    if (buffer_.size() + line.size() + 1 > CAPACITY) {
+      flush();
+    }
+    buffer_.append(line);
+    buffer_.push_back('\n');
+  }
+
+  // Writes already formatted lines with a single call, after any buffered
+  // ones, instead of copying them into the buffer.
+  void write(std::string_view lines) {
+    flush();
+    std::fwrite(lines.data(), 1, lines.size(), stdout);
+  }
+
+  void flush() {
+    std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+    buffer_.clear();
+  }
+
+ private:
+  std::string buffer_;
+};
+
+// Newline-delimited input from a memory-mapped file or the standard input.
+class input_reader {
+ public:
+  static std::optional<input_reader> open(const char* path) {
+    input_reader reader;
+    if (path == nullptr) {
+      return reader;
+    }
+    auto file = version_weaver::mapped_file::open(path);
+    if (!file.has_value()) {
+      if (file.error() != version_weaver::CATALOG_TRUNCATED) {
+        return std::nullopt;
+      }
+      // An empty file has nothing to map.
+      reader.done_ = true;
+      return reader;
+    }
+    reader.file_.emplace(std::move(*file));
+    return reader;
+  }
+
+  // Returns the next run of complete lines, or an empty view at the end.
+  std::string_view next_block() {
+    if (done_) {
+      return {};
+    }
+    if (file_.has_value()) {
+      std::string_view rest = mapped().substr(consumed_);
+      size_t end = rest.find('\n', std::min(BLOCK_SIZE, rest.size()));
+      end = end == std::string_view::npos ? rest.size() : end + 1;
+      consumed_ += end;
+      done_ = consumed_ == mapped().size();
+      return rest.substr(0, end);
+    }
+    // Keep the incomplete last line of the previous block.
+    buffer_.erase(0, consumed_);
+    size_t kept = buffer_.size();
+    buffer_.resize(kept + BLOCK_SIZE);
+    size_t read = std::fread(buffer_.data() + kept, 1, BLOCK_SIZE, stdin);
+    buffer_.resize(kept + read);
+    if (read == 0) {
+      done_ = true;
+      consumed_ = buffer_.size();
+      return buffer_;
+    }
+    size_t end = buffer_.rfind('\n');
+    consumed_ = end == std::string::npos ? 0 : end + 1;
+    if (consumed_ == 0) {
+      // A single line longer than a block: keep reading.
+      return next_block();
+    }
+    return std::string_view(buffer_).substr(0, consumed_);
+  }
+
+  // Returns the whole input, which stays valid as long as the reader.
+  std::string_view read_all() {
+    if (file_.has_value()) {
+      done_ = true;
+      return mapped();
+    }
+    std::string all;
+    for (auto block = next_block(); !block.empty(); block = next_block()) {
+      all.append(block);
+    }
+    buffer_ = std::move(all);
+    return buffer_;
+  }
+
+ private:
+  input_reader() = default;
+
+  std::string_view mapped() const {
+    auto bytes = file_->bytes();
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+  }
+
+  std::optional<version_weaver::mapped_file> file_;
+  std::string buffer_;
+  size_t consumed_ = 0;
+  bool done_ = false;
+};
+
+template <class function_type>
+static void for_each_line(std::string_view block, function_type&& function) {
+  while (!block.empty()) {
+    size_t end = block.find('\n');
+    std::string_view line = block.substr(0, end);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (!line.empty()) {
+      function(line);
+    }
+    if (end == std::string_view::npos) break;
+    block.remove_prefix(end + 1);
+  }
+}
+
+// Splits a block at line boundaries into at most `threads` chunks and runs
+// `function(chunk, index)` on each, in parallel. Returns the chunk count.
+static size_t for_each_chunk(
+    std::string_view block, size_t threads,
+    const std::function<void(std::string_view, size_t)>& function) {
+  if (threads <= 1 || block.size() < MIN_PARALLEL_BLOCK) {
+    function(block, 0);
+    return 1;
+  }
+  std::vector<std::string_view> chunks;
+  size_t target = block.size() / threads + 1;
+  while (!block.empty()) {
+    size_t end = block.find('\n', std::min(target, block.size() - 1));
+    end = end == std::string_view::npos ? block.size() : end + 1;
+    chunks.push_back(block.substr(0, end));
+    block.remove_prefix(end);
+  }
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < chunks.size(); i++) {
+    workers.emplace_back(function, chunks[i], i);
+  }
+  function(chunks[0], 0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return chunks.size();
+}
+
+// The text of a parsed version, which is a view into its input line.
+static std::string_view text_of(const version_weaver::version& v) {
+  std::string_view last = v.build     ? *v.build
+                          : v.pre_release ? *v.pre_release
+                                          : v.patch;
+  return {v.major.data(), size_t(last.data() + last.size() - v.major.data())};
+}
+
+// Runs `function(line, output)` over every line, in parallel, and writes the
+// outputs in input order. Each thread appends its output to its own string,
+// so a line is copied once before it is written. Returns the number of lines
+// for which the function returned true.
+static size_t transform_lines(
+    input_reader& input, output_buffer& output, size_t threads,
+    const std::function<bool(std::string_view, std::string&)>& function) {
+  size_t matches = 0;
+  std::vector<std::string> outputs(threads);
+  std::vector<size_t> counts(threads);
+  for (auto block = input.next_block(); !block.empty();
+       block = input.next_block()) {
+    size_t chunks =
+        for_each_chunk(block, threads, [&](std::string_view chunk, size_t i) {
+          outputs[i].clear();
+          counts[i] = 0;
+          for_each_line(chunk, [&](std::string_view line) {
+            counts[i] += function(line, outputs[i]);
+          });
+        });
+    for (size_t i = 0; i < chunks; i++) {
+      output.write(outputs[i]);
+      matches += counts[i];
+    }
+  }
+  return matches;
+}
+
+// Appends the valid versions among the lines of `chunk` to `output`. The
+// library parses one version at a time, so this is the batch path: it sizes
+// `output` for the chunk once and keeps the inlined parse() in a tight loop.
+static void parse_chunk(std::string_view chunk,
+                        std::vector<version_weaver::version>& output) {
+  size_t lines = std::count(chunk.begin(), chunk.end(), '\n') + 1;
+  output.reserve(output.size() + lines);
+  for_each_line(chunk, [&output](std::string_view line) {
+    if (auto v = version_weaver::parse(line)) {
+      output.push_back(*v);
+    }
+  });
+}
+
+static std::vector<version_weaver::version> parse_lines(
+    std::string_view block, size_t threads) {
+  std::vector<std::vector<version_weaver::version>> parsed(threads);
+  size_t chunks = for_each_chunk(
+      block, threads, [&parsed](std::string_view chunk, size_t i) {
+        parse_chunk(chunk, parsed[i]);
+      });
+  for (size_t i = 1; i < chunks; i++) {
+    parsed[0].insert(parsed[0].end(), parsed[i].begin(), parsed[i].end());
+  }
+  return std::move(parsed[0]);
+}
+
+static int usage() {
+  std::fputs(
+      "usage: version_weaver [-j|--threads THREADS] COMMAND [RANGE] [FILE]\n"
+      "commands: validate, sort, uniq, max-satisfying RANGE, filter RANGE, "
+      "coerce\n",
+      stderr);
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  size_t threads = 1;
+  int arg = 1;
+  if (arg + 1 < argc && (std::strcmp(argv[arg], "-j") == 0 ||
+                         std::strcmp(argv[arg], "--threads") == 0)) {
+    std::string_view count = argv[arg + 1];
+    auto [ptr, ec] =
+        std::from_chars(count.data(), count.data() + count.size(), threads);
+    if (ec != std::errc() || ptr != count.data() + count.size()) {
+      return usage();
+    }
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    arg += 2;
+  }
+  if (arg >= argc) {
+    return usage();
+  }
+  std::string_view command = argv[arg++];
+  std::optional<version_weaver::range> range;
+  if (command == "max-satisfying" || command == "filter") {
+    if (arg >= argc) {
+      return usage();
+    }
+    auto parsed = version_weaver::parse_range(argv[arg++]);
+    if (!parsed.has_value()) {
+      std::fprintf(stderr, "version_weaver: invalid range '%s'\n",
+                   argv[arg - 1]);
+      return 2;
+    }
+    range = std::move(*parsed);
+  } else if (command != "validate" && command != "sort" && command != "uniq" &&
+             command != "coerce") {
+    return usage();
+  }
+  if (arg + 1 < argc) {
+    return usage();
+  }
+  const char* path = arg < argc ? argv[arg] : nullptr;
+  auto input = input_reader::open(path);
+  if (!input.has_value()) {
+    std::fprintf(stderr, "version_weaver: cannot read '%s'\n", path);
+    return 2;
+  }
+  output_buffer output;
+
+  if (command == "validate") {
+    size_t invalid = transform_lines(
+        *input, output, threads, [](std::string_view line, std::string& out) {
+          if (version_weaver::validate(line)) {
+            return false;
+          }
+          out.append(line);
+          out.push_back('\n');
+          return true;
+        });
+    return invalid == 0 ? EXIT_SUCCESS : 1;
+  }
+  if (command == "filter") {
+    transform_lines(*input, output, threads,
+                    [&range](std::string_view line, std::string& out) {
+                      auto v = version_weaver::parse(line);
+                      if (!v.has_value() || !range->test(*v)) {
+                        return false;
+                      }
+                      out.append(text_of(*v));
+                      out.push_back('\n');
+                      return true;
+                    });
+    return EXIT_SUCCESS;
+  }
+  if (command == "coerce") {
+    transform_lines(*input, output, threads,
+                    [](std::string_view line, std::string& out) {
+                      auto coerced = version_weaver::coerce(line);
+                      if (!coerced.has_value()) {
+                        return false;
+                      }
+                      out.append(*coerced);
+                      out.push_back('\n');
+                      return true;
+                    });
+    return EXIT_SUCCESS;
+  }
+  if (command == "max-satisfying") {
+    // The best version so far is copied out, since blocks are reused.
+    std::string best_text;
+    std::optional<version_weaver::version> best;
+    version_weaver::compiled_range compiled(*range);
+    std::vector<std::optional<version_weaver::version>> bests(threads);
+    std::vector<std::vector<version_weaver::version>> parsed(threads);
+    for (auto block = input->next_block(); !block.empty();
+         block = input->next_block()) {
+      size_t chunks = for_each_chunk(
+          block, threads, [&](std::string_view chunk, size_t i) {
+            parsed[i].clear();
+            parse_chunk(chunk, parsed[i]);
+            bests[i] = version_weaver::max_satisfying(parsed[i], compiled);
+          });
+      for (size_t i = 0; i < chunks; i++) {
+        if (bests[i] && (!best || *best < *bests[i])) {
+          best_text = text_of(*bests[i]);
+          best = version_weaver::parse(best_text).value();
+        }
+      }
+    }
+    if (!best.has_value()) {
+      return 1;
+    }
+    output.write_line(best_text);
+    return EXIT_SUCCESS;
+  }
+
+  // sort and uniq need the whole input.
+  auto versions = parse_lines(input->read_all(), threads);
+  version_weaver::sort_versions(versions, threads);
+  size_t count = versions.size();
+  if (command == "uniq") {
+    count = version_weaver::unique_versions(versions);
+  }
+  for (size_t i = 0; i < count; i++) {
+    output.write_line(text_of(versions[i]));
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+# Runs `CLI ARGS` on INPUT and checks the exit status against STATUS and the
+# standard output against EXPECTED, or that nothing is printed without one.
+#
+# INPUT is piped through the standard input, or passed as the last argument
+# when FILE is set, which maps it. With THREADS set, INPUT is first repeated
+# past the size above which blocks are split across threads, and the output
+# of `CLI -j THREADS ARGS` must match that of `CLI ARGS` on one thread.
+function(run_cli output status)
+  if(FILE)
+    execute_process(
+      COMMAND ${CLI} ${ARGN} ${INPUT}
+      OUTPUT_VARIABLE result
+      RESULT_VARIABLE code
+    )
+  else()
+    execute_process(
+      COMMAND ${CLI} ${ARGN}
+      INPUT_FILE ${INPUT}
+      OUTPUT_VARIABLE result
+      RESULT_VARIABLE code
+    )
+  endif()
+  set(${output} "${result}" PARENT_SCOPE)
+  set(${status} "${code}" PARENT_SCOPE)
+endfunction()
+
+if(THREADS)
+  # 2^15 copies of the fixture are about 2.5 MB.
+  file(READ ${INPUT} text)
+  foreach(i RANGE 1 15)
+    set(text "${text}${text}")
+  endforeach()
+  set(INPUT ${CMAKE_CURRENT_BINARY_DIR}/cli_input_${NAME}.txt)
+  file(WRITE ${INPUT} "${text}")
+  run_cli(expected expected_status ${ARGS})
+  if(NOT expected_status EQUAL STATUS)
+    message(FATAL_ERROR "'${ARGS}' exited with ${expected_status}, "
+                        "expected ${STATUS}")
+  endif()
+  set(ARGS -j ${THREADS} ${ARGS})
+elseif(EXPECTED)
+  file(READ ${EXPECTED} expected)
+else()
+  set(expected "")
+endif()
+
+run_cli(output status ${ARGS})
+if(NOT status EQUAL STATUS)
+  message(FATAL_ERROR "'${ARGS}' exited with ${status}, expected ${STATUS}")
+endif()
+if(NOT output STREQUAL expected)
+  string(LENGTH "${output}" size)
+  string(LENGTH "${expected}" expected_size)
+  message(FATAL_ERROR "'${ARGS}' printed ${size} bytes instead of "
+                      "${expected_size}:\n${output}")
+endif()